@@ -0,0 +1,51 @@
+#pragma once
+
+#include "vma_usage.h"
+#include "pixelate_device.h"
+#include "timeline_manager.h"
+
+namespace Pixelate
+{
+	enum class BindlessResourceType : uint32_t
+	{
+		SampledImage = 0,
+		StorageImage = 1,
+		StorageBuffer = 2,
+	};
+	inline constexpr uint32_t BINDLESS_RESOURCE_TYPE_COUNT = 3;
+
+	// Position of a resource in its binding of the descriptor heap, passed to shaders through push constants
+	using BindlessIndex = uint32_t;
+	inline constexpr BindlessIndex INVALID_BINDLESS_INDEX = std::numeric_limits<uint32_t>::max();
+
+	// One global descriptor set built on descriptor indexing, shared by every pipeline without descriptor sets of its own:
+	//   binding 0: immutable samplers, see BindlessSampler
+	//   binding 1: sampled images, binding 2: storage images, binding 3: storage buffers (variable count)
+	// The pipeline layout has this set as set 0 and a push constant range of maxPushConstantsSize bytes for all stages.
+	// Descriptors are written update-after-bind, so registering never waits for the GPU and the set is bound once per command buffer.
+	namespace BindlessDescriptors
+	{
+		enum class BindlessSampler : uint32_t
+		{
+			LinearRepeat = 0,
+			LinearClamp = 1,
+			NearestRepeat = 2,
+			NearestClamp = 3,
+		};
+		inline constexpr uint32_t SAMPLER_COUNT = 4;
+
+		void Initialize(PixelateDevice device);
+		bool IsEnabled(); // false if the device lacks the descriptor indexing features
+
+		BindlessIndex RegisterSampledImage(VkImageView imageView, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		BindlessIndex RegisterStorageImage(VkImageView imageView);
+		BindlessIndex RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+		void Release(BindlessResourceType type, BindlessIndex index, TimelinePoint retireAfter); // reused once retireAfter has completed
+
+		VkDescriptorSetLayout GetDescriptorSetLayout();
+		VkPipelineLayout GetPipelineLayout();
+		void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint);
+
+		void Dispose(VkDevice device);
+	}
+}
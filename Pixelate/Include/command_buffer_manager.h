@@ -10,6 +10,7 @@ namespace Pixelate
 		GraphicsQueue,
 		ComputeQueue,
 	};
+	inline constexpr uint32_t COMMAND_BUFFER_TYPE_COUNT = 2;
 
 	enum class CommandBufferPerformanceProfile : uint32_t
 	{
@@ -22,8 +23,6 @@ namespace Pixelate
 		CommandBufferType Type = CommandBufferType::GraphicsQueue;
 		VkCommandBufferLevel Level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 		CommandBufferPerformanceProfile PerformanceProfile = CommandBufferPerformanceProfile::Default;
-
-		uint64_t Hash(VkDevice device); // thread-dependent hash!
 	};
 
 	struct PixelateVkCommandBuffer
@@ -36,9 +35,20 @@ namespace Pixelate
 		void Return();
 	};
 
+	// Every thread records into its own command pools, so nothing here takes a lock after a thread's first call.
 	namespace CommandBufferManager
 	{
+		// Valid until the frame-in-flight slot comes around again, never reset individually
+		VkCommandBuffer GetFrameCommandBuffer(PixelateDevice device, uint32_t frameInFlightIndex, CommandBufferDescriptor descriptor = CommandBufferDescriptor());
+
+		// Resets the command pools of every thread for the slot with vkResetCommandPool.
+		// Only call once the GPU has finished the slot's previous frame and no thread is recording into it.
+		void ResetFrame(VkDevice device, uint32_t frameInFlightIndex);
+
+		// Long-lived command buffers that are re-recorded in place, must be returned on the thread that got them
 		PixelateVkCommandBuffer GetCommandBuffer(PixelateDevice device, CommandBufferDescriptor descriptor = CommandBufferDescriptor());
 		void ReturnCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer, CommandBufferDescriptor descriptor = CommandBufferDescriptor());
+
+		void Dispose(VkDevice device);
 	}
 }
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+// Scopes are compiled in unless PXL8_DISABLE_CPU_PROFILER is defined, and cost one relaxed load while the profiler is disabled
+#define PXL8_CONCATENATE_INNER(a, b) a##b
+#define PXL8_CONCATENATE(a, b) PXL8_CONCATENATE_INNER(a, b)
+
+#ifdef PXL8_DISABLE_CPU_PROFILER
+#define PXL8_PROFILE_SCOPE(name)
+#else
+#define PXL8_PROFILE_SCOPE(name) ::Pixelate::CpuProfileScope PXL8_CONCATENATE(cpuProfileScope, __LINE__)(name)
+#endif
+
+namespace Pixelate
+{
+	struct CpuProfileEvent
+	{
+		const char* Name; // must outlive the profiler, string literals only
+		uint64_t Start; // nanoseconds since the profiler started
+		uint64_t End;
+	};
+
+	// Every thread writes its events into its own fixed size ring buffer, the oldest events are overwritten.
+	// Nothing on the recording path takes a lock after a thread's first event.
+	namespace CpuProfiler
+	{
+		inline constexpr uint32_t EVENTS_PER_THREAD = 1 << 14; // power of two
+		inline constexpr uint32_t MAX_TRACKED_FRAMES = 1024;
+
+		extern std::atomic<bool> g_Enabled;
+
+		inline bool IsEnabled() { return g_Enabled.load(std::memory_order_relaxed); }
+		void SetEnabled(bool enabled);
+		void SetThreadName(const char* name); // shown in the trace viewer
+
+		uint64_t Now();
+		void RecordEvent(const char* name, uint64_t start, uint64_t end);
+		void MarkFrame(); // call at the start of every frame, used to export the last N frames
+
+		// Chrome trace event JSON, loadable in chrome://tracing and Perfetto. 0 exports every event still buffered
+		std::string GetChromeTrace(uint32_t lastFrameCount = 0);
+		bool ExportChromeTrace(const std::string& filepath, uint32_t lastFrameCount = 0);
+	}
+
+	class CpuProfileScope
+	{
+	public:
+		CpuProfileScope(const char* name) : m_Name(name), m_Start(CpuProfiler::IsEnabled() ? CpuProfiler::Now() : 0) {}
+		~CpuProfileScope()
+		{
+			if (m_Start != 0)
+				CpuProfiler::RecordEvent(m_Name, m_Start, CpuProfiler::Now());
+		}
+
+		CpuProfileScope(const CpuProfileScope&) = delete;
+		CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start; // 0 if the profiler was disabled when the scope was entered
+	};
+}
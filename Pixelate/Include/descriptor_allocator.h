@@ -0,0 +1,32 @@
+#pragma once
+
+#include "vma_usage.h"
+
+namespace Pixelate
+{
+	struct DescriptorAllocatorStatistics
+	{
+		uint64_t AllocatedSetCount = 0; // since initialization
+		uint32_t PoolCount = 0; // across all threads and frames in flight
+	};
+
+	// Descriptor sets that live for one frame in flight, e.g. for per-draw uniform data.
+	// Every thread bump-allocates from its own chain of descriptor pools per frame-in-flight slot, a full pool chains a new one.
+	// Sets are never freed individually, the slot's pools are reset at once when the frame pacer recycles it.
+	namespace DescriptorAllocator
+	{
+		void Initialize(VkDevice device);
+
+		// Valid until the frame-in-flight slot comes around again. VK_NULL_HANDLE if the layout's
+		// descriptors don't fit an empty pool, see the pool sizes in descriptor_allocator.cpp.
+		VkDescriptorSet AllocateFrameSet(uint32_t frameInFlightIndex, VkDescriptorSetLayout layout);
+
+		// Resets the descriptor pools of every thread for the slot with vkResetDescriptorPool.
+		// Only call once the GPU has finished the slot's previous frame and no thread is recording into it.
+		void ResetFrame(uint32_t frameInFlightIndex);
+
+		DescriptorAllocatorStatistics GetStatistics();
+
+		void Dispose();
+	}
+}
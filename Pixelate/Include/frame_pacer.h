@@ -0,0 +1,63 @@
+#pragma once
+
+#include <chrono>
+#include "vma_usage.h"
+#include "pixelate_device.h"
+#include "pixelate_settings.h"
+#include "presentation_engine.h"
+#include "semaphore_manager.h"
+#include "timeline_manager.h"
+
+namespace Pixelate
+{
+	struct PixelateFrame
+	{
+		uint32_t FrameInFlightIndex;
+		uint32_t SwapchainImageIndex; // INVALID_SWAPCHAIN_IMAGE_INDEX if the swapchain has to be recreated first
+		PixelateSemaphore ImageAcquiredSemaphore;
+		TimelinePoint FrameComplete; // must be signaled by the last queue submission of the frame
+	};
+
+	struct FramePacingStatistics
+	{
+		uint64_t FrameCount = 0;
+		double FrameTimeMin = std::numeric_limits<double>::max(); // milliseconds
+		double FrameTimeMax = 0.0;
+		double FrameTimeSum = 0.0;
+		double FenceWaitSum = 0.0; // time the CPU spent blocked on the GPU
+
+		double AverageFrameTime() const { return FrameCount ? FrameTimeSum / FrameCount : 0.0; }
+		double AverageFenceWait() const { return FrameCount ? FenceWaitSum / FrameCount : 0.0; }
+		double CpuGpuOverlap() const { return FrameTimeSum > 0.0 ? 1.0 - FenceWaitSum / FrameTimeSum : 0.0; }
+	};
+
+	// Throttles the CPU so that at most MAX_FRAMES_IN_FLIGHT frames are queued on the GPU at any time.
+	// Frame N waits only on the graphics timeline value of frame N - MAX_FRAMES_IN_FLIGHT, never on the whole device.
+	class FramePacer
+	{
+	public:
+		FramePacer() = default;
+		FramePacer(PixelateDevice device);
+
+		PixelateFrame BeginFrame(PixelatePresentationEngine& presentation);
+		void EndFrame();
+
+		uint32_t GetFrameInFlightIndex() const { return m_FrameInFlightIndex; }
+		void SetSerializeFrames(bool serializeFrames) { m_SerializeFrames = serializeFrames; } // wait for device idle every frame, only useful as a pacing baseline
+		const FramePacingStatistics& GetStatistics() const { return m_Statistics; }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		PixelateDevice m_Device{};
+		uint32_t m_FrameInFlightIndex = 0;
+		bool m_SerializeFrames = false;
+		TimelinePoint m_FrameCompletePoints[PixelateSettings::MAX_FRAMES_IN_FLIGHT]{};
+		Clock::time_point m_LastFrameStart{};
+		double m_LastFenceWait = 0.0;
+		FramePacingStatistics m_Statistics{};
+		FramePacingStatistics m_IntervalStatistics{};
+
+		void RecordFrameTime(Clock::time_point frameStart);
+	};
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "vma_usage.h"
+#include "pixelate_device.h"
+#include "timeline_manager.h"
+
+namespace Pixelate
+{
+	// GPU time of one render graph pass, the minimum, average and maximum cover the current statistics interval
+	struct GpuPassTiming
+	{
+		const char* PassName = nullptr;
+		double LastTime = 0.0; // milliseconds
+		double TimeMin = std::numeric_limits<double>::max();
+		double TimeMax = 0.0;
+		double TimeSum = 0.0;
+		uint64_t SampleCount = 0;
+
+		double AverageTime() const { return SampleCount ? TimeSum / SampleCount : 0.0; }
+	};
+
+	// Timestamp queries around every pass, one query pool per frame in flight.
+	// Results are read once the frame pacer has waited for the slot, so reading never stalls.
+	namespace GpuProfiler
+	{
+		inline constexpr uint32_t MAX_TIMED_PASSES = 128;
+
+		void Initialize(PixelateDevice device);
+		bool IsEnabled(); // false if the graphics queue has no timestamp support
+
+		// Reset and write the queries inside the pass's own command buffer, so passes can be recorded in any order and on any thread
+		void BeginPass(VkCommandBuffer commandBuffer, uint32_t frameInFlightIndex, uint32_t passIndex, TimelineQueue queue = TimelineQueue::Graphics);
+		void EndPass(VkCommandBuffer commandBuffer, uint32_t frameInFlightIndex, uint32_t passIndex, TimelineQueue queue = TimelineQueue::Graphics);
+
+		// Never waits, passes whose queries aren't available yet get a negative time
+		void ReadPassTimes(uint32_t frameInFlightIndex, uint32_t passCount, std::vector<double>& passTimes);
+
+		void Dispose();
+	}
+}
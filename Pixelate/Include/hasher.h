@@ -1,60 +1,180 @@
 #pragma once
 
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
 namespace Pixelate
 {
-	constexpr uint64_t FNV_PRIME = 0x100000001b3ull; // FNV-1a 64-bit salt
-	
+	// wyhash-style constants, odd with balanced bits
+	constexpr uint64_t HASH_SECRET_0 = 0xa0761d6478bd642full;
+	constexpr uint64_t HASH_SECRET_1 = 0xe7037ed1a0b428dbull;
+	constexpr uint64_t HASH_SECRET_2 = 0x8ebc6af09c88c6e3ull;
+
+	// Streaming hash that consumes 16 bytes per 64x64->128 bit multiply instead of one byte per FNV step.
+	// Every member is constexpr, runtime calls use unaligned word loads and the native 128 bit multiply.
 	class Hasher
 	{
 	public:
-
-		void Hash(const char value)
+		constexpr void Hash(const char value)
 		{
-			m_Hash = (m_Hash ^ value) * FNV_PRIME;
+			Mix(static_cast<uint8_t>(value));
 		}
 
-		void Hash(const char* ptr, size_t size)
+		constexpr void Hash(const char* ptr, size_t size)
 		{
-			for (size_t i = 0; i < size; i++)
-				Hash(ptr[i]);
+			auto seed = m_Hash ^ HASH_SECRET_0;
+			size_t i = 0;
+
+			for (; i + 16 <= size; i += 16)
+				seed = Multiply(Read64(ptr + i) ^ HASH_SECRET_1, Read64(ptr + i + 8) ^ seed);
+
+			// 0-15 trailing bytes, read as two possibly overlapping words
+			uint64_t a = 0;
+			uint64_t b = 0;
+			auto remaining = size - i;
+
+			if (remaining >= 8)
+			{
+				a = Read64(ptr + i);
+				b = Read64(ptr + size - 8);
+			}
+			else if (remaining >= 4)
+			{
+				a = Read32(ptr + i);
+				b = Read32(ptr + size - 4);
+			}
+			else if (remaining > 0)
+			{
+				a = (static_cast<uint64_t>(static_cast<uint8_t>(ptr[i])) << 16)
+					| (static_cast<uint64_t>(static_cast<uint8_t>(ptr[i + remaining / 2])) << 8)
+					| static_cast<uint64_t>(static_cast<uint8_t>(ptr[size - 1]));
+			}
+
+			m_Hash = Multiply(a ^ HASH_SECRET_1 ^ size, b ^ seed);
 		}
 
-		void Hash(const uint16_t value)
+		constexpr void Hash(const uint16_t value)
 		{
-			Hash(static_cast<char>(value));
-			Hash(static_cast<char>(value >> 8));
+			Mix(value);
 		}
 
-		void Hash(const uint32_t value)
+		constexpr void Hash(const uint32_t value)
 		{
-			Hash(static_cast<uint16_t>(value));
-			Hash(static_cast<uint16_t>(value >> 16));
+			Mix(value);
 		}
 
-		void Hash(const uint64_t value)
+		constexpr void Hash(const uint64_t value)
 		{
-			Hash(static_cast<uint32_t>(value));
-			Hash(static_cast<uint32_t>(value >> 32));
+			Mix(value);
 		}
 
-		void Hash(const char*& string)
+		constexpr void Hash(const char*& string)
 		{
-			for (const char* character = string; *character != '\0'; ++character)
-				Hash(*character);
+			Hash(string, std::char_traits<char>::length(string));
 		}
 
-		void Hash(const std::string& string)
+		constexpr void Hash(std::string_view string) // also takes std::string
 		{
-			Hash(string.c_str(), string.size());
+			Hash(string.data(), string.size());
 		}
 
-		uint64_t GetValue() const
+		constexpr uint64_t GetValue() const
 		{
 			return m_Hash;
 		}
 
 	private:
-		uint64_t m_Hash = 0xcbf29ce484222325ull; // FNV-1a 64-bit initial hash value
+		uint64_t m_Hash = HASH_SECRET_2;
+
+		constexpr void Mix(uint64_t value)
+		{
+			m_Hash = Multiply(m_Hash ^ HASH_SECRET_0, value ^ HASH_SECRET_1);
+		}
+
+		// Folds the 128 bit product of a and b into 64 bits
+		static constexpr uint64_t Multiply(uint64_t a, uint64_t b)
+		{
+			if (!std::is_constant_evaluated())
+			{
+#if defined(__SIZEOF_INT128__)
+				auto product = static_cast<unsigned __int128>(a) * b;
+				return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+				uint64_t high = 0;
+				auto low = _umul128(a, b, &high);
+				return low ^ high;
+#endif
+			}
+
+			uint64_t aLow = a & 0xffffffffull, aHigh = a >> 32;
+			uint64_t bLow = b & 0xffffffffull, bHigh = b >> 32;
+
+			uint64_t lowLow = aLow * bLow;
+			uint64_t lowHigh = aLow * bHigh;
+			uint64_t highLow = aHigh * bLow;
+			uint64_t highHigh = aHigh * bHigh;
+
+			uint64_t middle = (lowLow >> 32) + (lowHigh & 0xffffffffull) + (highLow & 0xffffffffull);
+			uint64_t low = (middle << 32) | (lowLow & 0xffffffffull);
+			uint64_t high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+
+			return low ^ high;
+		}
+
+		// Little endian loads, memcpy compiles to a single unaligned load
+		static constexpr uint64_t Read64(const char* ptr)
+		{
+			if (!std::is_constant_evaluated() && std::endian::native == std::endian::little)
+			{
+				uint64_t value = 0;
+				std::memcpy(&value, ptr, sizeof(value));
+				return value;
+			}
+
+			uint64_t value = 0;
+			for (int i = 0; i < 8; i++)
+				value |= static_cast<uint64_t>(static_cast<uint8_t>(ptr[i])) << (8 * i);
+
+			return value;
+		}
+
+		static constexpr uint64_t Read32(const char* ptr)
+		{
+			if (!std::is_constant_evaluated() && std::endian::native == std::endian::little)
+			{
+				uint32_t value = 0;
+				std::memcpy(&value, ptr, sizeof(value));
+				return value;
+			}
+
+			uint64_t value = 0;
+			for (int i = 0; i < 4; i++)
+				value |= static_cast<uint64_t>(static_cast<uint8_t>(ptr[i])) << (8 * i);
+
+			return value;
+		}
 	};
 
+	// For keys known at compile time, e.g. constexpr auto key = HashKey("MainColorAttachment");
+	constexpr uint64_t HashKey(std::string_view key)
+	{
+		Hasher hasher;
+		hasher.Hash(key);
+		return hasher.GetValue();
+	}
+
+	static_assert(HashKey("MainColorAttachment") != HashKey("MainDepthAttachment"));
+
+	namespace Hashers
+	{
+		// Times Hasher against the previous byte-wise FNV-1a on descriptor sized inputs and logs the throughput
+		void LogBenchmark();
+	}
 }
@@ -83,10 +83,12 @@ inline constexpr bool VALIDATION_LAYERS_ENABLED = true;
 inline constexpr bool VALIDATION_LAYERS_ENABLED = false;
 #endif
 
-enum class Platform { Win64 };
+enum class Platform { Win64, Linux64 };
 
 #ifdef WIN64
 inline constexpr Platform PLATFORM = Platform::Win64;
+#elif defined(LINUX64)
+inline constexpr Platform PLATFORM = Platform::Linux64;
 #endif
 #endif
 
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <span>
+#include "vma_usage.h"
+#include "pixelate_render_pass.h"
+#include "resource_manager.h"
+#include "descriptor_allocator.h"
+#include "uniform_ring.h"
+#include "cpu_profiler.h"
+#include "log.h"
+
+namespace Pixelate
+{
+	// One of a pass's declared inputs or outputs with the physical resource the graph resolved it to.
+	// Resource is empty for the swapchain image and for resources the graph doesn't own.
+	struct PixelatePassResource
+	{
+		const char* Name = nullptr;
+		PixelateResourceUsageFlag UsageFlags = PIXELATE_USAGE_NONE;
+		TransientResource Resource{};
+	};
+
+	// Everything a pass callback records with, built on the stack of the recording thread for every command buffer of the pass.
+	// The frame allocators hand out memory that is only valid for FrameInFlightIndex's frame, they refuse PIXELATE_PASS_RECORD_ONCE passes.
+	struct PixelatePassContext
+	{
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE;
+		VkPipelineBindPoint BindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		const char* PassName = nullptr;
+		uint32_t PassIndex = 0;
+		uint32_t FrameInFlightIndex = 0;
+		uint32_t SliceIndex = 0; // always 0 of 1 for passes that aren't sliced
+		uint32_t SliceCount = 1;
+		std::span<const PixelatePassResource> Inputs{}; // in the order the pass declared them
+		std::span<const PixelatePassResource> Outputs{};
+		bool IsRecordedOnce = false; // PIXELATE_PASS_RECORD_ONCE, the command buffer is replayed after the frame's allocations are reset
+
+		// By name among the inputs, then the outputs, nullptr if the pass didn't declare it
+		const PixelatePassResource* FindResource(const char* name) const
+		{
+			for (const auto& input : Inputs)
+				if (strcmp(input.Name, name) == 0)
+					return &input;
+
+			for (const auto& output : Outputs)
+				if (strcmp(output.Name, name) == 0)
+					return &output;
+
+			return nullptr;
+		}
+
+		// VK_NULL_HANDLE for record-once passes
+		VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout layout) const
+		{
+			if (!CanUseFrameAllocators())
+				return VK_NULL_HANDLE;
+
+			return DescriptorAllocator::AllocateFrameSet(FrameInFlightIndex, layout);
+		}
+
+		// Invalid for record-once passes
+		UniformAllocation AllocateUniforms(VkDeviceSize size) const
+		{
+			if (!CanUseFrameAllocators())
+				return UniformAllocation{};
+
+			return UniformRing::Allocate(FrameInFlightIndex, size);
+		}
+
+		template <typename T>
+		UniformAllocation PushUniforms(const T& value) const
+		{
+			if (!CanUseFrameAllocators())
+				return UniformAllocation{};
+
+			return UniformRing::Push(FrameInFlightIndex, value);
+		}
+
+		// Into the pass's pipeline layout, whose push constant range must cover stageFlags, VK_SHADER_STAGE_ALL for the bindless layout
+		template <typename T>
+		void PushConstants(const T& value, VkShaderStageFlags stageFlags = VK_SHADER_STAGE_ALL, uint32_t offset = 0) const
+		{
+			vkCmdPushConstants(CommandBuffer, PipelineLayout, stageFlags, offset, sizeof(T), &value);
+		}
+
+		void BindDescriptorSet(uint32_t set, VkDescriptorSet descriptorSet, std::span<const uint32_t> dynamicOffsets = {}) const
+		{
+			vkCmdBindDescriptorSets(CommandBuffer, BindPoint, PipelineLayout, set, 1, &descriptorSet, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+		}
+
+		// e.g. auto scope = context.ProfileScope("DrawOpaque"); the name must be a string literal
+		CpuProfileScope ProfileScope(const char* name) const
+		{
+			return CpuProfileScope(name);
+		}
+
+	private:
+		bool CanUseFrameAllocators() const
+		{
+			if (!IsRecordedOnce)
+				return true;
+
+			PXL8_CORE_ERROR(std::string("Pass ") + PassName + " is recorded once and can't use the frame allocators!");
+			assert(!"Record-once passes can't use the frame allocators");
+
+			return false;
+		}
+	};
+}
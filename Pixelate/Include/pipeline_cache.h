@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include "vma_usage.h"
+#include "pixelate_device.h"
+
+namespace Pixelate::PipelineCache
+{
+	// Loads the cache from disk if the header matches this device and driver, otherwise starts with an empty cache
+	void Initialize(PixelateDevice device, const std::string& filepath);
+	VkPipelineCache GetVkPipelineCache();
+	void Save(VkDevice device);
+	void Dispose(VkDevice device); // saves before destroying
+}
@@ -1,19 +1,104 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <future>
 #include "pixelate_render_pass.h"
 #include "vma_usage.h"
 
 namespace Pixelate
 {
+	struct PipelineCompileState
+	{
+		std::atomic<VkPipeline> Pipeline = VK_NULL_HANDLE; // set by the compile worker once the pipeline is created
+		std::shared_future<VkPipeline> Compiled;
+	};
+
+	// Handle to a pipeline that may still be compiling on a worker thread
+	class PipelineHandle
+	{
+	public:
+		PipelineHandle() = default;
+		PipelineHandle(std::shared_ptr<PipelineCompileState> state) : m_State(std::move(state)) {}
+
+		bool IsValid() const { return m_State != nullptr; }
+		bool IsReady() const { return Get() != VK_NULL_HANDLE; }
+		VkPipeline Get() const { return m_State ? m_State->Pipeline.load(std::memory_order_acquire) : VK_NULL_HANDLE; } // VK_NULL_HANDLE until compiled
+		VkPipeline Wait() const { return m_State ? m_State->Compiled.get() : VK_NULL_HANDLE; }
+
+	private:
+		std::shared_ptr<PipelineCompileState> m_State;
+	};
+
+	// Pipeline state that is set while recording instead of being baked into the pipeline, taken from the pass's descriptor
+	struct PixelateDynamicState
+	{
+		VkPipelineInputAssemblyStateCreateInfo InputAssembly;
+		VkPipelineRasterizationStateCreateInfo RasterizationState;
+		VkPipelineDepthStencilStateCreateInfo DepthStencilState;
+		float BlendConstants[4];
+	};
+
 	namespace Pipelines
 	{
-		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts(VkDevice device, GraphicsPipelineDescriptor& descriptor);
-		VkPipelineLayout GetPipelineLayout(VkDevice device, GraphicsPipelineDescriptor& descriptor);
+		// Core in Vulkan 1.3, which the profile requires. Left out of the pipeline key, so resizes and
+		// passes that only differ in e.g. cull mode or depth testing don't compile new pipelines.
+		inline constexpr std::array<VkDynamicState, 20> DYNAMIC_STATES
+		{
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR,
+			VK_DYNAMIC_STATE_LINE_WIDTH,
+			VK_DYNAMIC_STATE_DEPTH_BIAS,
+			VK_DYNAMIC_STATE_BLEND_CONSTANTS,
+			VK_DYNAMIC_STATE_DEPTH_BOUNDS,
+			VK_DYNAMIC_STATE_STENCIL_COMPARE_MASK,
+			VK_DYNAMIC_STATE_STENCIL_WRITE_MASK,
+			VK_DYNAMIC_STATE_STENCIL_REFERENCE,
+			VK_DYNAMIC_STATE_CULL_MODE,
+			VK_DYNAMIC_STATE_FRONT_FACE,
+			VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+			VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+			VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+			VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE,
+			VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE,
+			VK_DYNAMIC_STATE_STENCIL_OP,
+			VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE,
+			VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE,
+			VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE,
+		};
+
+		PixelateDynamicState GetDynamicState(const GraphicsPipelineDescriptor& descriptor);
+
+		// Sets all of DYNAMIC_STATES, the viewport and scissor cover the render area.
+		// Needed in every command buffer that draws, secondary command buffers don't inherit it.
+		void SetDynamicState(VkCommandBuffer commandBuffer, const PixelateDynamicState& dynamicState, VkRect2D renderArea);
+
+		// Pipelines without descriptor set layouts or push constant ranges of their own share the bindless descriptor heap's layout
+		bool UsesBindlessLayout(const GraphicsPipelineDescriptor& descriptor);
+		bool UsesBindlessLayout(const ComputePipelineDescriptor& descriptor);
+
+		// Cached by content, equal layouts of different passes are the same handles. Owned by Pipelines, never destroy them.
+		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts(VkDevice device, const GraphicsPipelineDescriptor& descriptor);
+		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts(VkDevice device, const ComputePipelineDescriptor& descriptor);
+		VkPipelineLayout GetPipelineLayout(VkDevice device, const GraphicsPipelineDescriptor& descriptor);
+		VkPipelineLayout GetPipelineLayout(VkDevice device, const ComputePipelineDescriptor& descriptor);
+
+		// Returns immediately, the pipeline is compiled on the pipeline compile worker pool
+		PipelineHandle RequestGraphicsPipeline(
+			VkDevice device,
+			const PixelatePass& pass,
+			VkFormat swapchainFormat);
+
+		// Blocks until the pipeline has been compiled
 		VkPipeline GetGraphicsPipeline(
 			VkDevice device,
 			const PixelatePass& pass,
-			VkViewport viewport,
-			VkRect2D scissor,
 			VkFormat swapchainFormat);
+
+		// Compute pipelines don't depend on the swapchain, the key is the descriptor's hash alone
+		PipelineHandle RequestComputePipeline(VkDevice device, const PixelatePass& pass);
+		VkPipeline GetComputePipeline(VkDevice device, const PixelatePass& pass);
+
+		void Dispose(VkDevice device);
 	}
-}
\ No newline at end of file
+}
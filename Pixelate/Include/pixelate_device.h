@@ -11,7 +11,18 @@ namespace Pixelate
 	{
 		std::optional<uint32_t> PresentQueueFamily;
 		std::optional<uint32_t> GraphicsQueueFamily;
-		std::optional<uint32_t> ComputeQueueFamily;
+		std::optional<uint32_t> ComputeQueueFamily; // the graphics family if the device has no separate compute family
+		std::optional<uint32_t> TransferQueueFamily; // the graphics family if the device has no usable transfer-only family
+
+		bool HasAsyncCompute() const { return ComputeQueueFamily.has_value() && ComputeQueueFamily != GraphicsQueueFamily; }
+		bool HasDedicatedTransfer() const { return TransferQueueFamily.has_value() && TransferQueueFamily != GraphicsQueueFamily; }
+	};
+
+	// Features outside the profile, enabled at device creation when the physical device supports them
+	struct OptionalDeviceFeatures
+	{
+		bool Maintenance5 = false; // VK_KHR_maintenance5, shader stages can take SPIR-V without a shader module
+		bool DescriptorIndexing = false; // runtime sized, partially bound and update-after-bind descriptor arrays for the bindless descriptor heap
 	};
 
 	struct PixelateDevice
@@ -20,5 +31,6 @@ namespace Pixelate
 		VkDevice VkDevice;
 		VkPhysicalDevice VkPhysicalDevice;
 		QueueFamilyIndices QueueFamilyIndices;
+		OptionalDeviceFeatures OptionalFeatures{};
 	};
 }
\ No newline at end of file
@@ -5,4 +5,32 @@
 namespace Pixelate::Helpers
 {
 	std::vector<char> ReadFile(const std::string& filename);
+	bool FileExists(const std::string& filename);
+	bool WriteFileAtomic(const std::string& filename, const void* data, size_t size); // writes to a temporary file and renames it into place
+
+	// Read-only memory mapping of a whole file, the pages are loaded on first access instead of copied up front
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		MappedFile(const std::string& filename);
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		bool IsValid() const { return m_Data != nullptr; }
+		const char* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		const char* m_Data = nullptr;
+		size_t m_Size = 0;
+#ifdef WIN64
+		void* m_Mapping = nullptr;
+#endif
+
+		void Unmap();
+	};
 }
\ No newline at end of file
@@ -14,7 +14,14 @@
 #include <condition_variable>
 
 #include "log.h"
+#include "cpu_profiler.h"
+#include "hasher.h"
 #include "renderer.h"
+#include "upload_engine.h"
+#include "bindless_descriptors.h"
+#include "descriptor_allocator.h"
+#include "uniform_ring.h"
+#include "pass_context.h"
 
 // Todo:
 //  Create vkInstance! [x]
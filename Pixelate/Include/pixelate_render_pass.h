@@ -1,5 +1,7 @@
 #pragma once
 
+#include <new>
+#include <type_traits>
 #include "vma_usage.h"
 
 namespace Pixelate
@@ -9,6 +11,8 @@ namespace Pixelate
 		const char* Name;
 		const char* Path; // path to containing folder
 		VkShaderStageFlags ShaderStages;
+
+		std::string GetStagePath(VkShaderStageFlagBits stage) const; // e.g. <Path>/<Name>_vertex.spv
 	};
 
 	struct GraphicsPipelineDescriptor
@@ -67,9 +71,20 @@ namespace Pixelate
 		VkPipelineDepthStencilStateCreateInfo DepthStencilState = DefaultDepthStencilState;
 		VkPipelineColorBlendStateCreateInfo ColorBlendingState = DefaultColorBlendingState;
 
+		// Content-addressed: hashes the SPIR-V of every stage and the fixed-function state field by field,
+		// never pointers or pNext chains, and skips state that is disabled or dynamic. Equal pipelines hash equal.
 		uint64_t Hash() const;
 	};
 
+	struct ComputePipelineDescriptor
+	{
+		PixelateShaderDescriptor ShaderDescriptor = {}; // ShaderStages = VK_SHADER_STAGE_COMPUTE_BIT, loaded from <Path>/<Name>_compute.spv
+		std::vector<std::vector<VkDescriptorSetLayoutBinding>> DescriptorSetLayoutBindings = {};
+		std::vector<VkPushConstantRange> PushConstantRanges = {};
+
+		uint64_t Hash() const; // content-addressed like GraphicsPipelineDescriptor::Hash
+	};
+
 	typedef enum PixelatePassFlagBits : size_t
 	{
 		PIXELATE_PASS_NO_FLAG = 0,
@@ -83,9 +98,61 @@ namespace Pixelate
 		None = 0,
 		Graphics = 1,
 		Host = 2,
+		Compute = 3, // may run on the async compute queue, see RenderGraphScheduler
 	};
 
-	typedef void (*CommandGraphics)(VkCommandBuffer commandBuffer, VkPipeline pipelineHandle);
+	struct PixelatePassContext; // pass_context.h
+
+	inline constexpr size_t PASS_CALLBACK_STORAGE_SIZE = 56; // the callback is one cache line with its invoker
+
+	// Records a pass's commands. Takes a function, a captureless lambda or a small functor, stored inline without a heap allocation.
+	// The functor type is known to the invoker, so calling it costs one indirect call and the functor body is inlined into the invoker.
+	// That indirect call is kept on purpose: passes of different callback types share the graph's runtime pass list, so the recording
+	// code can't know the type statically, and one call through a pointer is what the raw function pointers cost before.
+	// Takes void(PixelatePassContext&), or the older void(VkCommandBuffer, VkPipeline) and, for slices, void(VkCommandBuffer, VkPipeline, uint32_t sliceIndex, uint32_t sliceCount).
+	class PassCallback
+	{
+	public:
+		PassCallback() = default; // trivial, so the callback can live in the passes' unions
+		constexpr PassCallback(std::nullptr_t) : m_Storage{}, m_pInvoke(nullptr) {}
+
+		template <typename F>
+			requires (!std::is_same_v<std::decay_t<F>, PassCallback>)
+		PassCallback(F functor) : m_Storage{}, m_pInvoke(&Invoke<F>)
+		{
+			// Never destroyed and copied bytewise together with the pass
+			static_assert(sizeof(F) <= PASS_CALLBACK_STORAGE_SIZE, "Pass callback functor is too large, capture a pointer to the state instead.");
+			static_assert(alignof(F) <= alignof(std::max_align_t), "Pass callback functor is overaligned.");
+			static_assert(std::is_trivially_copyable_v<F> && std::is_trivially_destructible_v<F>, "Pass callback functors must be trivially copyable and destructible.");
+
+			new (m_Storage) F(functor);
+		}
+
+		void operator()(PixelatePassContext& context) const { m_pInvoke(m_Storage, context); }
+		bool operator==(std::nullptr_t) const { return m_pInvoke == nullptr; }
+
+	private:
+		alignas(std::max_align_t) unsigned char m_Storage[PASS_CALLBACK_STORAGE_SIZE];
+		void (*m_pInvoke)(const void* pFunctor, PixelatePassContext& context);
+
+		// Context is only a template parameter so the context's members are looked up once it is complete
+		template <typename F, typename Context = PixelatePassContext>
+		static void Invoke(const void* pFunctor, Context& context)
+		{
+			const auto& functor = *std::launder(reinterpret_cast<const F*>(pFunctor));
+
+			if constexpr (std::is_invocable_v<const F&, Context&>)
+				functor(context);
+			else if constexpr (std::is_invocable_v<const F&, VkCommandBuffer, VkPipeline, uint32_t, uint32_t>)
+				functor(context.CommandBuffer, context.Pipeline, context.SliceIndex, context.SliceCount);
+			else
+				functor(context.CommandBuffer, context.Pipeline);
+		}
+	};
+
+	using CommandGraphics = PassCallback;
+	using CommandGraphicsSlice = PassCallback;
+	using CommandCompute = PassCallback;
 	typedef void (*CommandHost)();
 
 	struct HostPipelineDescriptor
@@ -185,23 +252,33 @@ namespace Pixelate
 			struct {} NoPipeline;
 			GraphicsPipelineDescriptor GraphicsPipelineDescriptor;
 			HostPipelineDescriptor HostPipelineDescriptor;
+			ComputePipelineDescriptor ComputePipelineDescriptor;
 		};
 		union
 		{
 			void* CommandBufferNone;
 			CommandGraphics CommandBufferGraphics;
 			CommandHost CommandBufferHost;
+			CommandCompute CommandBufferCompute;
 		};
 
 		std::vector<PixelateResourceUsage> Inputs;
 		std::vector<PixelateResourceUsage> Outputs;
 
+		// Optional, splits the draws of a graphics pass into SliceCount secondary command buffers recorded in parallel
+		CommandGraphicsSlice CommandBufferGraphicsSlice = nullptr;
+		uint32_t SliceCount = 1;
+
 		PixelatePass();
 		PixelatePass(const PixelatePass& other);
 		PixelatePass& operator=(const PixelatePass& other);
 		PixelatePass(PixelatePass&& other) noexcept;
 		PixelatePass& operator=(PixelatePass&& other) noexcept;
 		PixelatePass(const char* name, Pixelate::GraphicsPipelineDescriptor&& pipeline, PixelatePassFlags flags, CommandGraphics commandBuffer, std::vector<PixelateResourceUsage>&& inputs, std::vector<PixelateResourceUsage>&& outputs);
+		PixelatePass(const char* name, Pixelate::ComputePipelineDescriptor&& pipeline, PixelatePassFlags flags, CommandCompute commandBuffer, std::vector<PixelateResourceUsage>&& inputs, std::vector<PixelateResourceUsage>&& outputs);
 		~PixelatePass();
+
+	private:
+		void DestroyPipelineDescriptor(); // destroys the union member of PassType, leaves a None pass
 	};
 }
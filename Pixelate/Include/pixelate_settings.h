@@ -7,4 +7,13 @@ namespace PixelateSettings
 	inline constexpr VkFormat PREFERRED_SWAPCHAIN_IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
 	inline constexpr VkColorSpaceKHR PREFERRED_SWAPCHAIN_COLOR_SPACE = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
 	inline constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
-}
\ No newline at end of file
+	inline constexpr uint32_t FRAME_STATISTICS_LOG_INTERVAL = 512; // frames
+	inline constexpr const char* PIPELINE_CACHE_FILEPATH = "pipeline_cache.bin";
+	inline constexpr uint32_t PASS_RECORDING_THREAD_COUNT = 0; // 0 uses one thread per core, leaving one for the render thread
+	inline constexpr VkDeviceSize UPLOAD_STAGING_RING_SIZE = 64ull * 1024 * 1024; // bytes of staging memory shared by all uploads in flight
+	inline constexpr VkDeviceSize UNIFORM_RING_FRAME_SIZE = 4ull * 1024 * 1024; // bytes of per-frame constants each frame in flight can allocate
+	inline constexpr uint32_t BINDLESS_SAMPLED_IMAGE_CAPACITY = 16384; // descriptor heap slots, clamped to the device's update-after-bind limits
+	inline constexpr uint32_t BINDLESS_STORAGE_IMAGE_CAPACITY = 1024;
+	inline constexpr uint32_t BINDLESS_STORAGE_BUFFER_CAPACITY = 16384;
+	inline constexpr bool ASYNC_COMPUTE = true; // compute passes may overlap graphics work on a separate compute queue family
+}
@@ -4,6 +4,7 @@
 #include "SDL2/SDL.h"
 #include "SDL2/SDL_vulkan.h"
 #include "pixelate_device.h"
+#include "timeline_manager.h"
 
 namespace Pixelate
 {
@@ -18,6 +19,16 @@ namespace Pixelate
 		std::vector<VkPresentModeKHR> PresentModes;
 	};
 
+	// What a recreation replaced, destroyed once the frames that used it have completed
+	struct RetiredSwapchain
+	{
+		VkSwapchainKHR VkSwapchain = VK_NULL_HANDLE;
+		std::vector<VkImageView> ImageViews{};
+		std::vector<VkImage> OffscreenImages{}; // headless, swapchain images belong to the swapchain
+		std::vector<VmaAllocation> OffscreenAllocations{};
+		TimelinePoint RetireAfter{};
+	};
+
 	class PixelateSwapchain
 	{
 	public:
@@ -31,13 +42,22 @@ namespace Pixelate
 	public:
 		PixelateSwapchain() = default;
 		PixelateSwapchain(PixelateDevice device, VkSurfaceKHR surface, SDL_Window* window);
+		PixelateSwapchain(PixelateDevice device, VmaAllocator allocator, VkExtent2D extent); // headless, a ring of offscreen images
 		void Dispose();
-		void Recreate();
+		// Re-queries the surface and hands the current swapchain over as oldSwapchain. False if the surface has no area, e.g. while minimized.
+		bool Recreate(SDL_Window* window, VkExtent2D headlessExtent, RetiredSwapchain& retired);
+		void DisposeRetired(RetiredSwapchain& retired) const;
+		bool IsHeadless() const { return m_Allocator != VK_NULL_HANDLE; }
 	private:
+		void Create();
+		void CreateImageViews();
+		void CreateOffscreenImages();
 		void DisposeImageViews();
 	private:
 		PixelateDevice m_Device;
-		VkSurfaceKHR m_Surface;
+		VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
+		VmaAllocator m_Allocator = VK_NULL_HANDLE;
+		std::vector<VmaAllocation> m_OffscreenAllocations{};
 
 	};
 
@@ -45,6 +65,14 @@ namespace Pixelate
 
 	class PixelateSemaphore;
 
+	enum class PresentationBackend : uint32_t
+	{
+		Window = 0,
+		Headless = 1, // no window or surface, renders into offscreen images, for CI and render nodes
+	};
+
+	inline constexpr uint32_t INVALID_SWAPCHAIN_IMAGE_INDEX = std::numeric_limits<uint32_t>::max(); // acquire found the swapchain out of date
+
 	class PixelatePresentationEngine
 	{
 	public:
@@ -53,20 +81,26 @@ namespace Pixelate
 		const SDL_Window* GetWindow() const { return m_Window; }
 		const VkSurfaceKHR GetSurface() const { return m_VkSurfaceKHR; }
 		const PixelateSwapchain GetSwapchain() const { return m_Swapchain; }
+		bool IsHeadless() const { return m_Backend == PresentationBackend::Headless; }
+		bool IsSwapchainOutOfDate() const;
 
 	public:
 		PixelatePresentationEngine(int width, int height, SDL_Window* window, VkSurfaceKHR surface);
-		void Initialize(PixelateDevice device);
+		PixelatePresentationEngine(int width, int height); // headless
+		void Initialize(PixelateDevice device, VmaAllocator allocator);
 		uint32_t AcquireSwapcahinImage(VkSemaphore signalSemaphore = VK_NULL_HANDLE, VkFence signalFence = VK_NULL_HANDLE);
 		void Present(
 			uint32_t swapchainImageIndex,
 			VkSemaphoreSubmitInfo* pWaitSemaphore,
-			uint32_t waitSemaphoreCount,
-			//PixelateSemaphore swapchainImageReadyToPresentSemaphore,
-			VkImageLayout previousLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+			uint32_t waitSemaphoreCount);
+		void ResizeSurface(int width, int height); // resizes the window, or the simulated surface when headless
+		bool RecreateSwapchain(TimelinePoint retireAfter); // retireAfter: the last submission that may use the current images
+		void DisposeRetiredSwapchains(); // the ones whose frames have completed
+		uint64_t GetSwapchainGeneration() const { return m_SwapchainGeneration; }
 		void Dispose(VkInstance instance);
 
 	private:
+		PresentationBackend m_Backend;
 		int m_Width;
 		int m_Height;
 		SDL_Window* m_Window;
@@ -74,17 +108,10 @@ namespace Pixelate
 		PixelateDevice m_Device;
 		PixelateSwapchain m_Swapchain;
 		VkQueue m_PresentQueue;
-
-	private:
-		void TransitionImageLayout(
-			uint32_t swapchainImageIndex,
-			VkSemaphoreSubmitInfo* pSignalSemaphore = nullptr,
-			uint32_t signalSemaphoreCount = 0,
-			VkSemaphoreSubmitInfo* pWaitSemaphore = nullptr,
-			uint32_t waitSemaphoreCount = 0,
-			VkImageLayout newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-			VkImageLayout oldLayout = VK_IMAGE_LAYOUT_UNDEFINED);
-	private:
-		std::vector<VkCommandBuffer> m_ImageTransitionCommandBuffers;
+		uint32_t m_NextOffscreenImage = 0;
+		bool m_SwapchainOutOfDate = false; // reported by acquire or present, or set by a resize
+		VkExtent2D m_DrawableExtent{}; // of the window when the swapchain was last created
+		uint64_t m_SwapchainGeneration = 0;
+		std::vector<RetiredSwapchain> m_RetiredSwapchains{};
 	};
 }
\ No newline at end of file
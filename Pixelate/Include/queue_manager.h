@@ -27,6 +27,17 @@ namespace Pixelate
 		uint64_t Hash(VkDevice device);
 	};
 
+	enum class TransferQueueType : uint32_t
+	{
+		Default = 0,
+	};
+
+	struct TransferQueueSubmitDescriptor
+	{
+		TransferQueueType Type;
+		uint64_t Hash(VkDevice device);
+	};
+
 	namespace QueueManager
 	{
 		void GraphicsQueueSubmit(
@@ -49,5 +60,34 @@ namespace Pixelate
 			VkSemaphoreSubmitInfo* pWaitSemaphores,
 			uint32_t waitSemaphoreCount);
 
+		// Submits several batches in a single vkQueueSubmit2 call, the fence signals once all of them complete
+		void GraphicsQueueSubmit(
+			PixelateDevice device,
+			GraphicsQueueSubmitDescriptor descriptor,
+			const VkSubmitInfo2* pSubmitInfos,
+			uint32_t submitInfoCount,
+			VkFence signalFence);
+
+		// Goes to the graphics queue if the device has no separate compute family
+		void ComputeQueueSubmit(
+			PixelateDevice device,
+			ComputeQueueSubmitDescriptor descriptor,
+			const VkSubmitInfo2* pSubmitInfos,
+			uint32_t submitInfoCount,
+			VkFence signalFence);
+
+		// Goes to the graphics queue if the device has no separate transfer family
+		void TransferQueueSubmit(
+			PixelateDevice device,
+			TransferQueueSubmitDescriptor descriptor,
+			const VkSubmitInfo2* pSubmitInfos,
+			uint32_t submitInfoCount,
+			VkFence signalFence);
+
+		// Every submit and present takes the mutex of its VkQueue, so any thread may call these
+		VkResult QueuePresent(VkQueue queue, const VkPresentInfoKHR* pPresentInfo);
+
+		// vkDeviceWaitIdle with every queue locked
+		void DeviceWaitIdle(VkDevice device);
 	}
 }
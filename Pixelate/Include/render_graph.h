@@ -1,11 +1,17 @@
 #pragma once
 
+#include <chrono>
 #include "presentation_engine.h"
 #include "pixelate_render_pass.h"
 #include "pipeline_manager.h"
+#include "render_graph_barriers.h"
+#include "render_graph_scheduler.h"
+#include "resource_manager.h"
 #include "pixelate_settings.h"
 #include "semaphore_manager.h"
-#include "fence_manager.h"
+#include "timeline_manager.h"
+#include "gpu_profiler.h"
+#include "pass_context.h"
 
 namespace Pixelate
 {
@@ -23,35 +29,102 @@ namespace Pixelate
 		std::optional<VkRenderingAttachmentInfo> StencilAttachment = std::nullopt;
 	};
 
+	struct PixelateRecordedCommandBuffer
+	{
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		uint64_t RecordedStateHash = 0; // hash of everything the recording depends on, 0 if never recorded
+	};
+
 	struct PixelateRuntimePass
 	{
 		const char* PassName;
 		PassType PassType;
 		PixelatePassFlags Flags;
 		VkDevice Device;
-		VkPipeline Pipeline;
+		PipelineHandle Pipeline; // may still be compiling, the pass only clears its attachments until it is ready
+		PixelateDynamicState DynamicState; // set before the draws of every command buffer of the pass
+		TimelineQueue Queue = TimelineQueue::Graphics; // compute passes may run on the async compute queue
+		bool BindsDescriptorHeap = false; // the pipeline uses the bindless layout, the heap is bound before the pass's commands
+		VkPipelineLayout PipelineLayout = VK_NULL_HANDLE; // cached by Pipelines, handed to the callbacks through the pass context
 		union
 		{
 			CommandGraphics CommandBufferGraphics;
 			CommandHost CommandBufferHost;
+			CommandCompute CommandBufferCompute;
 		};
-		VkCommandBuffer CommandBuffer[PixelateSettings::MAX_FRAMES_IN_FLIGHT];
+		CommandGraphicsSlice CommandBufferGraphicsSlice = nullptr; // when set the draws are split into SliceCount secondary command buffers
+		uint32_t SliceCount = 1;
+		std::vector<VkFormat> ColorAttachmentFormats; // inherited by the secondary command buffers of sliced passes
+		VkFormat DepthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		std::vector<VkCommandBuffer> SliceCommandBuffers; // secondary command buffers of the current frame, one per slice
 		PixelateRenderingInfo RenderingInfos[PixelateSettings::MAX_FRAMES_IN_FLIGHT];
+		std::vector<PixelateRecordedCommandBuffer> RecordedCommandBuffers; // PIXELATE_PASS_RECORD_ONCE only, one per (frame in flight, swapchain image)
+		PixelatePassBarriers BarriersBeforePass;
+		PixelatePassBarriers BarriersAfterPass;
+		std::vector<PixelatePassResource> Inputs; // resolved again when the graph's resources are reallocated
+		std::vector<PixelatePassResource> Outputs;
 	};
 
 	class RenderGraph
 	{
 	public:
-		RenderGraph(PixelateDevice device, const RenderGraphDescriptor& descriptor, const PixelateSwapchain& swapchain);
-		std::tuple<FenceGroup, PixelateSemaphore> RecordAndSubmit(
+		RenderGraph(PixelateDevice device, VulkanResourceManager& resourceManager, const RenderGraphDescriptor& descriptor, const PixelateSwapchain& swapchain);
+		PixelateSemaphore RecordAndSubmit(
 			PixelateDevice device,
 			uint32_t frameInFlightIndex,
 			uint32_t swapchainImageIndex,
 			VkSemaphoreSubmitInfo* pWaitSemaphores,
 			uint32_t waitSemaphoreCount,
-			const PixelateSwapchain& swapchain);
+			const PixelateSwapchain& swapchain,
+			TimelinePoint frameComplete);
+		bool ArePipelinesReady() const;
+		void WaitForPipelines() const;
+		void InvalidateRecordedPasses(); // call when swapchain images or graph resources are recreated
+		// Patches the state that depends on the swapchain, resources are only reallocated if they follow its extent.
+		// Old resources are retired after retireAfter, pipelines and command pools stay untouched.
+		void OnSwapchainRecreated(PixelateDevice device, VulkanResourceManager& resourceManager, const PixelateSwapchain& swapchain, TimelinePoint retireAfter);
+		const TransientResourceStatistics& GetResourceStatistics() const { return m_TransientResources.Statistics; }
+		const std::vector<GpuPassTiming>& GetGpuPassTimings() const { return m_GpuPassTimings; } // one per pass, a frame-in-flight cycle behind
+
+		static void DisposeRecordingWorkers(); // before the command pools, the workers own some of them
 	private:
+		// A whole pass, or one slice of a sliced pass, recorded on the pass recording worker pool
+		struct PassRecordingJob
+		{
+			uint32_t PassIndex;
+			uint32_t Slice; // WHOLE_PASS for a primary command buffer of the entire pass
+			VkPipeline Pipeline;
+		};
+		static constexpr uint32_t WHOLE_PASS = std::numeric_limits<uint32_t>::max();
+
+
 		std::vector<PixelateRuntimePass> RuntimePasses;
+		std::vector<PixelatePass> m_Passes; // the graph's descriptor, to rebuild swapchain dependent state from
+		VkExtent2D m_SwapchainExtent{};
+		VkFormat m_SwapchainFormat = VK_FORMAT_UNDEFINED;
+		TransientResourceSet m_TransientResources; // owned by the resource manager, the graph only holds the handles
+		std::chrono::steady_clock::time_point m_BuildStart;
+		bool m_PipelinesReady = false;
+		uint64_t m_ResourceGeneration = 1;
+		PixelateGraphSchedule m_Schedule;
+		TimelinePoint m_LastFrameComplete{}; // the async compute queue waits for it before touching shared resources again
+		std::vector<VkCommandBufferSubmitInfo> m_CommandBufferSubmitInfos; // reused every frame to avoid allocations
+		std::vector<VkSemaphoreSubmitInfo> m_SemaphoreSubmitInfos;
+		std::vector<VkSemaphoreSubmitInfo> m_BatchSignals; // per batch, what the other queue waits on
+		std::vector<VkSubmitInfo2> m_SubmitInfos; // per batch
+		std::vector<VkCommandBuffer> m_PassCommandBuffers; // per pass, written by the recording jobs
+		std::vector<PassRecordingJob> m_RecordingJobs;
+		double m_RecordingTimeSum = 0.0; // ms, since the statistics were last logged
+		uint32_t m_RecordedFrameCount = 0;
+		std::vector<GpuPassTiming> m_GpuPassTimings;
+		std::vector<double> m_GpuPassTimes; // reused every frame to avoid allocations
+		uint32_t m_TimedPassCounts[PixelateSettings::MAX_FRAMES_IN_FLIGHT]{}; // passes with queries in flight per slot
+		uint32_t m_TimedFrameCount = 0;
+
+		void CollectGpuPassTimings(uint32_t frameInFlightIndex);
+
+		void RunRecordingJob(PixelateDevice device, uint32_t frameInFlightIndex, uint32_t swapchainImageIndex, const PixelateSwapchain& swapchain, const PassRecordingJob& job);
+		void RecordPasses(PixelateDevice device, uint32_t frameInFlightIndex, uint32_t swapchainImageIndex, const PixelateSwapchain& swapchain);
 
 	};
 }
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include "vma_usage.h"
+#include "pixelate_render_pass.h"
+
+namespace Pixelate
+{
+	struct PixelateResourceState
+	{
+		VkPipelineStageFlags2 StageMask = VK_PIPELINE_STAGE_2_NONE;
+		VkAccessFlags2 AccessMask = VK_ACCESS_2_NONE;
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED; // ignored for buffers
+		VkImageAspectFlags AspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	};
+
+	// All barriers one pass needs at one point of its command buffer, recorded with a single vkCmdPipelineBarrier2
+	struct PixelatePassBarriers
+	{
+		std::vector<VkImageMemoryBarrier2> ImageBarriers{}; // .image is resolved when the pass is recorded
+		std::vector<const char*> ImageBarrierResources{}; // resource name per image barrier, nullptr for the swapchain image
+		std::vector<VkBufferMemoryBarrier2> BufferBarriers{}; // queue family ownership transfers only, .buffer is resolved like .image
+		std::vector<const char*> BufferBarrierResources{};
+		VkMemoryBarrier2 MemoryBarrier{}; // all other buffer hazards of the pass merged into one global barrier
+
+		bool HasMemoryBarrier() const { return MemoryBarrier.srcStageMask != VK_PIPELINE_STAGE_2_NONE || MemoryBarrier.dstStageMask != VK_PIPELINE_STAGE_2_NONE; }
+		bool IsEmpty() const { return ImageBarriers.empty() && BufferBarriers.empty() && !HasMemoryBarrier(); }
+	};
+
+	struct PixelateGraphBarriers
+	{
+		std::vector<PixelatePassBarriers> BeforePass{}; // one per pass, recorded before rendering begins
+		std::vector<PixelatePassBarriers> AfterPass{}; // one per pass, holds the transition to present of the last swapchain write
+	};
+
+	namespace RenderGraphBarriers
+	{
+		// Tracks the state of every resource across the passes in submission order and
+		// computes the minimal set of barriers between them. Resources sharing memory are
+		// synchronized against the previous occupant named in aliasPredecessors.
+		// passQueueFamilies holds the queue family each pass runs on, empty if all run on one queue. A resource
+		// changing families gets a release after its last use on the old family and an acquire before the next use,
+		// the semaphore between the two queues' submissions is up to the caller.
+		PixelateGraphBarriers Synthesize(
+			const std::vector<PixelatePass>& passes,
+			const std::map<std::string, std::string>& aliasPredecessors = {},
+			const std::vector<uint32_t>& passQueueFamilies = {});
+		void Record(VkCommandBuffer commandBuffer, PixelatePassBarriers& barriers, VkImage swapchainImage);
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "vma_usage.h"
+#include "pixelate_render_pass.h"
+#include "timeline_manager.h"
+
+namespace Pixelate
+{
+	// Passes submitted together as one VkSubmitInfo2 on one queue, in graph order
+	struct PixelateSubmissionBatch
+	{
+		TimelineQueue Queue = TimelineQueue::Graphics;
+		std::vector<uint32_t> Passes{};
+		int32_t WaitBatch = -1; // latest batch on the other queue this one depends on, it covers all earlier ones
+		bool WaitsForSwapchainImage = false; // starts with the first pass writing the swapchain image
+		bool IsWaitedOn = false; // signals the other queue when done
+	};
+
+	struct PixelateGraphSchedule
+	{
+		std::vector<TimelineQueue> PassQueues{}; // one per pass
+		std::vector<PixelateSubmissionBatch> Batches{}; // in submission order, batches only wait on earlier ones
+		uint32_t AsyncComputePassCount = 0;
+
+		bool HasAsyncCompute() const { return AsyncComputePassCount > 0; }
+	};
+
+	namespace RenderGraphScheduler
+	{
+		// Compute passes that some graphics pass neither depends on nor is depended on by go to the async compute queue,
+		// everything else stays on the graphics queue. Passes sharing a resource depend on each other, the exclusive
+		// resources change queue family between them. The last graphics batch waits for all compute work, so the
+		// frame's graphics timeline value covers both queues.
+		PixelateGraphSchedule Schedule(const std::vector<PixelatePass>& passes, bool hasAsyncComputeQueue);
+	}
+}
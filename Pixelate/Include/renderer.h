@@ -4,12 +4,14 @@
 #include "resource_manager.h"
 #include "presentation_engine.h"
 #include "render_graph.h"
+#include "frame_pacer.h"
 
 namespace Pixelate
 {
 	// Instance
 
 	constexpr const char* VK_KHR_win32_surface_extension = "VK_KHR_win32_surface";
+	constexpr const char* VK_KHR_xlib_surface_extension = "VK_KHR_xlib_surface";
 	constexpr const char* VK_KHR_surface_extension = "VK_KHR_surface";
 
 	struct PixelateInstance
@@ -21,16 +23,32 @@ namespace Pixelate
 		VkDebugUtilsMessengerEXT DebugMessenger;
 	};
 
+	// Time from finding the swapchain out of date to having the new swapchain and the patched graph, in milliseconds
+	struct SwapchainRecreationStatistics
+	{
+		uint64_t RecreationCount = 0;
+		double LastTime = 0.0;
+		double TimeMin = std::numeric_limits<double>::max();
+		double TimeMax = 0.0;
+		double TimeSum = 0.0;
+
+		double AverageTime() const { return RecreationCount ? TimeSum / RecreationCount : 0.0; }
+	};
+
 	// Renderer
 
 	class Renderer
 	{
 	public:
-		Renderer(const char* applicationName, int x, int y, int width, int height, const char* vulkanProfileName = PixelateVulkanProfile::PROFILE_NAME, const int profileSpecVersion = PixelateVulkanProfile::PROFILE_SPEC_VERSION, unsigned int minApiVersion = PixelateVulkanProfile::PROFILE_MIN_API_VERSION);
+		Renderer(const char* applicationName, int x, int y, int width, int height, PresentationBackend presentationBackend = PresentationBackend::Window, const char* vulkanProfileName = PixelateVulkanProfile::PROFILE_NAME, const int profileSpecVersion = PixelateVulkanProfile::PROFILE_SPEC_VERSION, unsigned int minApiVersion = PixelateVulkanProfile::PROFILE_MIN_API_VERSION);
 
-		const VulkanResourceManager& GetImageManager() const { m_VulkanResourceManager; }
+		const VulkanResourceManager& GetImageManager() const { return m_VulkanResourceManager; }
 
-		void Render(RenderGraph renderGraph, std::function<bool()> inputHandler);
+		void Render(RenderGraph& renderGraph, std::function<bool()> inputHandler);
+		const FramePacingStatistics& GetFramePacingStatistics() const { return m_FramePacer.GetStatistics(); }
+		const SwapchainRecreationStatistics& GetSwapchainRecreationStatistics() const { return m_SwapchainRecreationStatistics; }
+		void ResizeSurface(int width, int height) { m_Presentation.ResizeSurface(width, height); } // the swapchain follows before the next frame
+		void SetSerializeFrames(bool serializeFrames) { m_FramePacer.SetSerializeFrames(serializeFrames); } // pacing baseline, see FramePacer
 		RenderGraph BuildRenderGraph(RenderGraphDescriptor& descriptor);
 		const SDL_Window* GetWindow() const;
 
@@ -41,6 +59,9 @@ namespace Pixelate
 		PixelatePresentationEngine m_Presentation;
 		PixelateDevice m_Device;
 		VulkanResourceManager m_VulkanResourceManager;
-		uint32_t m_FrameInFlightIndex = 0;
+		FramePacer m_FramePacer;
+		SwapchainRecreationStatistics m_SwapchainRecreationStatistics;
+
+		bool RecreateSwapchain(RenderGraph& renderGraph);
 	};
 }
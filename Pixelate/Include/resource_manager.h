@@ -1,6 +1,10 @@
 #pragma once
 
+#include <map>
 #include "vma_usage.h"
+#include "pixelate_render_pass.h"
+#include "timeline_manager.h"
+#include "bindless_descriptors.h"
 
 namespace Pixelate
 {
@@ -20,6 +24,7 @@ namespace Pixelate
 		vmaCreateInfo.device = device;
 		vmaCreateInfo.physicalDevice = physicalDevice;
 		vmaCreateInfo.vulkanApiVersion = vulkanApiVersion;
+		vmaCreateInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT; // bufferDeviceAddress is required by the profile
 
 		VmaAllocator vmaAllocator;
 		vmaCreateAllocator(&vmaCreateInfo, &vmaAllocator);
@@ -27,23 +32,122 @@ namespace Pixelate
 		return vmaAllocator;
 	}
 
+	// A render graph resource that lives for the lifetime of the graph, used from pass FirstPass to pass LastPass every frame
+	struct TransientResourceDescriptor
+	{
+		const char* Name;
+		PixelateResourceType Type;
+		VkImageCreateInfo ImageCreateInfo{}; // Type == Image
+		VkImageAspectFlags ImageAspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		VkBufferCreateInfo BufferCreateInfo{}; // Type == Buffer
+		uint32_t FirstPass = 0;
+		uint32_t LastPass = 0;
+		bool CanAlias = false; // first access every frame is a write, so contents never need to survive outside the lifetime
+		bool IsTransientAttachment = false; // only used as an attachment inside a single pass, never stored to memory
+	};
+
+	struct TransientResource
+	{
+		PixelateResourceType Type = PixelateResourceType::Image;
+		VkImage Image = VK_NULL_HANDLE;
+		VkImageView ImageView = VK_NULL_HANDLE;
+		VkExtent2D Extent{};
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		bool IsTransientAttachment = false;
+		const char* AliasPredecessor = nullptr; // resource last using the same memory before this one, nullptr if the memory isn't shared
+	};
+
+	struct TransientResourceStatistics
+	{
+		VkDeviceSize RequestedBytes = 0; // sum of all resource sizes, what a naive allocator would use
+		VkDeviceSize AllocatedBytes = 0; // device memory actually allocated for aliased and non-aliased resources
+		VkDeviceSize LazilyAllocatedBytes = 0; // resources placed in lazily allocated memory, usually never backed on tiled GPUs
+		uint32_t MemoryBlockCount = 0;
+
+		VkDeviceSize BytesSaved() const { return RequestedBytes - AllocatedBytes; }
+	};
+
+	struct TransientResourceSet
+	{
+		std::map<std::string, TransientResource> Resources{};
+		std::vector<VmaAllocation> Allocations{};
+		TransientResourceStatistics Statistics{};
+
+		const TransientResource* Find(const char* name) const;
+	};
+
+	// Device local resources that live until the resource manager is disposed, filled through the upload engine
+	struct BufferDescriptor
+	{
+		const char* Name;
+		VkDeviceSize Size = 0;
+		VkBufferUsageFlags Usage = 0; // transfer destination is always added
+	};
+
+	struct ImageDescriptor
+	{
+		const char* Name;
+		VkImageCreateInfo ImageCreateInfo{}; // transfer destination is always added
+		VkImageAspectFlags ImageAspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	};
+
+	struct PixelateBuffer
+	{
+		VkBuffer Buffer = VK_NULL_HANDLE;
+		VkDeviceSize Size = 0;
+		BindlessIndex StorageIndex = INVALID_BINDLESS_INDEX; // registered with the descriptor heap if created with storage usage
+	};
+
+	struct PixelateImage
+	{
+		VkImage Image = VK_NULL_HANDLE;
+		VkImageView ImageView = VK_NULL_HANDLE;
+		VkExtent3D Extent{};
+		VkFormat Format = VK_FORMAT_UNDEFINED;
+		BindlessIndex SampledIndex = INVALID_BINDLESS_INDEX; // in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, if created with sampled usage
+		BindlessIndex StorageIndex = INVALID_BINDLESS_INDEX; // in VK_IMAGE_LAYOUT_GENERAL, if created with storage usage
+	};
+
 	class VulkanResourceManager
 	{
 	public:
-		VulkanResourceManager(VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, unsigned int vulkanApiVersion)
-			: m_VmaAllocator(CreateVmaAllocator(instance, device, physicalDevice, vulkanApiVersion))
-		{}
+		VulkanResourceManager() = default;
+		VulkanResourceManager(VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, unsigned int vulkanApiVersion);
 
-		VkImageView RequestImageView(ImageViewDescriptor imageViewDescriptor)
-		{
-			
-		}
+		VkImageView RequestImageView(ImageViewDescriptor imageViewDescriptor);
+		VmaAllocator GetAllocator() const { return m_VmaAllocator; }
+
+		PixelateBuffer CreateBuffer(const BufferDescriptor& descriptor);
+		PixelateImage CreateImage(const ImageDescriptor& descriptor);
 
-		void Dispose() {}
+		// Resources whose lifetimes don't overlap share memory, the caller has to synchronize the hand-over between them
+		TransientResourceSet AllocateTransientResources(const std::vector<TransientResourceDescriptor>& descriptors);
+		// Destroys the set once retireAfter has completed, for graphs that reallocate their resources, e.g. on a resize
+		void RetireTransientResources(const TransientResourceSet& resourceSet, TimelinePoint retireAfter);
+		void DisposeRetiredResources(); // the ones whose frames have completed
+
+		void Dispose();
 
 	private:
-		VmaAllocator m_VmaAllocator;
+		VkDevice m_Device = VK_NULL_HANDLE;
+		VmaAllocator m_VmaAllocator = VK_NULL_HANDLE;
+		bool m_HasLazilyAllocatedMemory = false;
 		std::map<uint64_t, PixelateResourceReference<VkImageView>> m_ImageViews;
+		std::vector<VkImage> m_Images;
+		std::vector<VkBuffer> m_Buffers;
+		std::vector<VmaAllocation> m_Allocations;
+
+		struct RetiredResources
+		{
+			std::vector<VkImageView> ImageViews{};
+			std::vector<VkImage> Images{};
+			std::vector<VkBuffer> Buffers{};
+			std::vector<VmaAllocation> Allocations{};
+			TimelinePoint RetireAfter{};
+		};
+		std::vector<RetiredResources> m_RetiredResources;
+
+		void DisposeRetired(RetiredResources& retired);
 	};
 
-}
\ No newline at end of file
+}
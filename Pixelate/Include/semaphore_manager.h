@@ -4,11 +4,13 @@
 
 namespace Pixelate
 {
+	// Binary semaphores, only used where the swapchain requires them and for graphics to compute hand-offs inside a frame,
+	// where the frame's graphics timeline value is already taken by the frame's end. Everything else synchronizes on the TimelineManager queue timelines.
 	enum class SemaphoreIdentifier : uint32_t
 	{
 		SwapchainImageHasBeenAcquired = 1,
-		SwapchainImageTransitionToPresent = 2,
 		SwapchainImageReadyToPresent = 4,
+		GraphicsToComputeHandoff = 8,
 	};
 
 	struct SemaphoreDescriptor
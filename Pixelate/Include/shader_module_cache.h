@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include "vma_usage.h"
+#include "pixelate_device.h"
+
+namespace Pixelate
+{
+	// SPIR-V of one shader stage, valid until it is released
+	struct ShaderStageCode
+	{
+		uint64_t ContentHash = 0;
+		VkShaderModule Module = VK_NULL_HANDLE; // VK_NULL_HANDLE when the SPIR-V is passed inline
+		VkShaderModuleCreateInfo CreateInfo{}; // chained into VkPipelineShaderStageCreateInfo::pNext when Module is VK_NULL_HANDLE
+	};
+
+	// Memory mapped SPIR-V and shader modules, shared by every path with the same content and reference counted.
+	// Modules only live while pipelines are being created from them, with VK_KHR_maintenance5 none are created at all.
+	namespace ShaderModules
+	{
+		void Initialize(PixelateDevice device);
+
+		uint64_t GetContentHash(const std::string& path); // the file is only read the first time
+
+		ShaderStageCode Acquire(const std::string& path);
+		void Release(const ShaderStageCode& code); // the module and mapping are freed with the last reference
+
+		void Dispose(VkDevice device);
+	}
+}
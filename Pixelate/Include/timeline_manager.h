@@ -0,0 +1,39 @@
+#pragma once
+
+#include "vma_usage.h"
+
+namespace Pixelate
+{
+	enum class TimelineQueue : uint32_t
+	{
+		Graphics = 0,
+		Compute = 1,
+		Transfer = 2,
+	};
+	inline constexpr uint32_t TIMELINE_QUEUE_COUNT = 3;
+
+	// A point on a queue's timeline, reached once every submission up to and including the one signaling Value has completed
+	struct TimelinePoint
+	{
+		TimelineQueue Queue = TimelineQueue::Graphics;
+		uint64_t Value = 0; // the timelines start at 0, so the default point is always complete
+	};
+
+	// One timeline semaphore per queue with a monotonically increasing value.
+	// Binary semaphores are only left for the swapchain, which can't use timelines.
+	namespace TimelineManager
+	{
+		void Initialize(VkDevice device);
+		VkSemaphore GetSemaphore(TimelineQueue queue);
+
+		TimelinePoint Reserve(TimelineQueue queue); // the next value, the caller must signal it from a submission or the host
+		TimelinePoint GetLastReserved(TimelineQueue queue);
+		bool IsComplete(TimelinePoint point);
+		void Wait(TimelinePoint point, uint64_t timeout = std::numeric_limits<uint64_t>::max());
+		void Signal(TimelinePoint point); // for reserved values that never reached a queue
+
+		VkSemaphoreSubmitInfo GetSubmitInfo(TimelinePoint point, VkPipelineStageFlags2 stageMask);
+
+		void Dispose();
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstring>
+#include "vma_usage.h"
+#include "pixelate_device.h"
+
+namespace Pixelate
+{
+	// A chunk of the ring, written through pData and read by the GPU during the frame it was allocated for
+	struct UniformAllocation
+	{
+		void* pData = nullptr; // nullptr if the frame's part of the ring is full
+		VkBuffer Buffer = VK_NULL_HANDLE; // the same buffer for every allocation, so one descriptor covers all of them
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+		VkDeviceAddress DeviceAddress = 0;
+
+		bool IsValid() const { return pData != nullptr; }
+		uint32_t GetDynamicOffset() const { return static_cast<uint32_t>(Offset); } // for descriptors written with offset 0
+	};
+
+	// Per-frame constants without per-frame allocations: a host-visible, persistently mapped buffer split into one part per frame in flight.
+	// Allocations are bumped off the frame's part from any thread and bound with dynamic offsets or read through buffer device addresses.
+	// A frame's part is rewound when the frame pacer recycles the slot, so nothing is ever freed individually.
+	namespace UniformRing
+	{
+		void Initialize(PixelateDevice device, VmaAllocator allocator);
+
+		// Aligned for uniform and storage buffer offsets, size is rounded up to that alignment
+		UniformAllocation Allocate(uint32_t frameInFlightIndex, VkDeviceSize size);
+
+		template <typename T>
+		UniformAllocation Push(uint32_t frameInFlightIndex, const T& value)
+		{
+			auto allocation = Allocate(frameInFlightIndex, sizeof(T));
+			if (allocation.IsValid())
+				std::memcpy(allocation.pData, &value, sizeof(T));
+
+			return allocation;
+		}
+
+		VkBuffer GetBuffer();
+		VkDeviceSize GetMaxBindingRange(); // largest range a uniform buffer descriptor of the ring may have
+
+		// Only call once the GPU has finished the slot's previous frame and no thread is recording into it
+		void ResetFrame(uint32_t frameInFlightIndex);
+
+		void Dispose();
+	}
+}
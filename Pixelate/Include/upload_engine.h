@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vma_usage.h"
+#include "pixelate_device.h"
+#include "timeline_manager.h"
+
+namespace Pixelate
+{
+	// One subresource of an image, its previous contents are discarded
+	struct ImageUploadDescriptor
+	{
+		VkImage Image = VK_NULL_HANDLE;
+		VkExtent3D Extent{};
+		VkImageAspectFlags AspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		uint32_t MipLevel = 0;
+		uint32_t ArrayLayer = 0;
+		VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // the layout the graphics queue finds the image in
+	};
+
+	// Totals since initialization, stalls are waits for staging memory the GPU still reads from
+	struct UploadStatistics
+	{
+		uint64_t UploadCount = 0;
+		uint64_t UploadedBytes = 0;
+		uint64_t SubmitCount = 0;
+		uint64_t StallCount = 0;
+		double StallTime = 0.0; // milliseconds
+	};
+
+	// Copies host data into device local resources through a persistently mapped staging ring.
+	// Copies are batched into one command buffer on the transfer queue, or on the graphics queue if the device has no transfer-only family,
+	// and submitted when the renderer flushes once per frame or when the ring runs out of space.
+	// Thread safe, submits from upload threads go through the QueueManager, which serializes them with the renderer's submits to the same VkQueue.
+	namespace UploadEngine
+	{
+		void Initialize(PixelateDevice device, VmaAllocator allocator);
+
+		// The returned point on the transfer timeline is reached by the Flush submitting the copy, resources larger than the ring are split.
+		// Resources uploaded before the frame's Flush can be used by that frame's passes on the graphics queue.
+		TimelinePoint UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* pData, VkDeviceSize size);
+		TimelinePoint UploadImage(const ImageUploadDescriptor& descriptor, const void* pData, VkDeviceSize size); // tightly packed texels, must fit the ring
+
+		// Submits the pending copies. With a transfer-only family the graphics queue acquires the resources in a command buffer of the frame,
+		// which waits on the transfer timeline, so the frame's passes are ordered after the copies.
+		TimelinePoint Flush(uint32_t frameInFlightIndex);
+
+		const UploadStatistics& GetStatistics();
+		void LogBenchmark(VkDeviceSize byteCount); // uploads byteCount bytes into a scratch buffer and logs the throughput
+
+		void Dispose();
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <vector>
+#include "thread_safe_fifo_queue.h"
+
+namespace Pixelate
+{
+	class WorkerPool
+	{
+	public:
+		WorkerPool(const char* name, uint32_t threadCount);
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+		~WorkerPool();
+
+		void Submit(std::function<void()> job);
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+		void Dispose(); // finishes queued jobs, then joins all threads
+
+		static uint32_t GetDefaultThreadCount(); // one thread per core, leaving one for the render thread
+
+	private:
+		const char* m_Name;
+		std::vector<std::thread> m_Threads;
+		ThreadSafeFifoQueue<std::function<void()>> m_Jobs;
+
+		void WorkerLoop();
+	};
+}
@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include "bindless_descriptors.h"
+#include "pixelate_settings.h"
+#include "log.h"
+
+namespace Pixelate::BindlessDescriptors
+{
+	static constexpr uint32_t s_SamplerBinding = 0;
+	static constexpr uint32_t s_FirstResourceBinding = 1; // followed by one binding per BindlessResourceType
+	static constexpr uint32_t s_MaxPushConstantsSize = 128; // the profile's minimum
+
+	struct RetiredIndex
+	{
+		TimelinePoint RetireAfter{};
+		BindlessIndex Index = INVALID_BINDLESS_INDEX;
+	};
+
+	// Slots of one binding, released ones are reused once the last work referencing them has completed
+	struct HeapBinding
+	{
+		VkDescriptorType Type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		uint32_t Capacity = 0;
+		uint32_t Next = 0; // slots from here on were never handed out
+		std::vector<BindlessIndex> FreeIndices{};
+		std::deque<RetiredIndex> RetiredIndices{};
+	};
+
+	std::mutex g_Mutex;
+	VkDevice g_Device = VK_NULL_HANDLE;
+	bool g_Enabled = false;
+	VkSampler g_Samplers[SAMPLER_COUNT]{};
+	VkDescriptorSetLayout g_DescriptorSetLayout = VK_NULL_HANDLE;
+	VkDescriptorPool g_DescriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet g_DescriptorSet = VK_NULL_HANDLE;
+	VkPipelineLayout g_PipelineLayout = VK_NULL_HANDLE;
+	HeapBinding g_Bindings[BINDLESS_RESOURCE_TYPE_COUNT]{};
+
+	static bool CreateSamplers(VkDevice device)
+	{
+		struct SamplerMode
+		{
+			VkFilter Filter;
+			VkSamplerMipmapMode MipmapMode;
+			VkSamplerAddressMode AddressMode;
+		};
+
+		// In BindlessSampler order
+		constexpr SamplerMode modes[SAMPLER_COUNT]
+		{
+			{ VK_FILTER_LINEAR, VK_SAMPLER_MIPMAP_MODE_LINEAR, VK_SAMPLER_ADDRESS_MODE_REPEAT },
+			{ VK_FILTER_LINEAR, VK_SAMPLER_MIPMAP_MODE_LINEAR, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE },
+			{ VK_FILTER_NEAREST, VK_SAMPLER_MIPMAP_MODE_NEAREST, VK_SAMPLER_ADDRESS_MODE_REPEAT },
+			{ VK_FILTER_NEAREST, VK_SAMPLER_MIPMAP_MODE_NEAREST, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE },
+		};
+
+		for (uint32_t i = 0; i < SAMPLER_COUNT; i++)
+		{
+			VkSamplerCreateInfo samplerCreateInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+				.magFilter = modes[i].Filter,
+				.minFilter = modes[i].Filter,
+				.mipmapMode = modes[i].MipmapMode,
+				.addressModeU = modes[i].AddressMode,
+				.addressModeV = modes[i].AddressMode,
+				.addressModeW = modes[i].AddressMode,
+				.maxLod = VK_LOD_CLAMP_NONE,
+			};
+
+			if (vkCreateSampler(device, &samplerCreateInfo, nullptr, &g_Samplers[i]) != VK_SUCCESS)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Clamps the configured capacities to the device's update-after-bind limits, all of them are visible to every stage
+	static void SetCapacities(VkPhysicalDevice physicalDevice)
+	{
+		VkPhysicalDeviceVulkan12Properties vulkan12Properties{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES };
+		VkPhysicalDeviceProperties2 properties{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &vulkan12Properties };
+		vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+		auto& sampledImages = g_Bindings[static_cast<uint32_t>(BindlessResourceType::SampledImage)];
+		auto& storageImages = g_Bindings[static_cast<uint32_t>(BindlessResourceType::StorageImage)];
+		auto& storageBuffers = g_Bindings[static_cast<uint32_t>(BindlessResourceType::StorageBuffer)];
+
+		sampledImages.Type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		sampledImages.Capacity = std::min({ PixelateSettings::BINDLESS_SAMPLED_IMAGE_CAPACITY,
+			vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+		storageImages.Type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		storageImages.Capacity = std::min({ PixelateSettings::BINDLESS_STORAGE_IMAGE_CAPACITY,
+			vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageImages, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageImages });
+
+		storageBuffers.Type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		storageBuffers.Capacity = std::min({ PixelateSettings::BINDLESS_STORAGE_BUFFER_CAPACITY,
+			vulkan12Properties.maxDescriptorSetUpdateAfterBindStorageBuffers, vulkan12Properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+		// Halve the largest binding until everything fits the per-stage resource limit
+		uint32_t resourceLimit = vulkan12Properties.maxPerStageUpdateAfterBindResources - SAMPLER_COUNT;
+		while (sampledImages.Capacity + storageImages.Capacity + storageBuffers.Capacity > resourceLimit)
+		{
+			auto& largest = *std::max_element(std::begin(g_Bindings), std::end(g_Bindings), [](const HeapBinding& a, const HeapBinding& b) { return a.Capacity < b.Capacity; });
+			largest.Capacity /= 2;
+		}
+	}
+
+	void Initialize(PixelateDevice device)
+	{
+		g_Device = device.VkDevice;
+
+		if (!device.OptionalFeatures.DescriptorIndexing)
+		{
+			PXL8_CORE_WARN("Descriptor indexing isn't supported, the bindless descriptor heap is disabled.");
+			return;
+		}
+
+		SetCapacities(device.VkPhysicalDevice);
+
+		if (!CreateSamplers(device.VkDevice))
+		{
+			PXL8_CORE_ERROR("Failed to create the bindless samplers!");
+			return;
+		}
+
+		std::vector<VkDescriptorSetLayoutBinding> layoutBindings{};
+		std::vector<VkDescriptorBindingFlags> bindingFlags{};
+		std::vector<VkDescriptorPoolSize> poolSizes{};
+
+		layoutBindings.push_back(VkDescriptorSetLayoutBinding
+		{
+			.binding = s_SamplerBinding,
+			.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+			.descriptorCount = SAMPLER_COUNT,
+			.stageFlags = VK_SHADER_STAGE_ALL,
+			.pImmutableSamplers = g_Samplers,
+		});
+		bindingFlags.push_back(0);
+		poolSizes.push_back(VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_SAMPLER, SAMPLER_COUNT });
+
+		for (uint32_t i = 0; i < BINDLESS_RESOURCE_TYPE_COUNT; i++)
+		{
+			layoutBindings.push_back(VkDescriptorSetLayoutBinding
+			{
+				.binding = s_FirstResourceBinding + i,
+				.descriptorType = g_Bindings[i].Type,
+				.descriptorCount = g_Bindings[i].Capacity,
+				.stageFlags = VK_SHADER_STAGE_ALL,
+			});
+			bindingFlags.push_back(VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+			poolSizes.push_back(VkDescriptorPoolSize{ g_Bindings[i].Type, g_Bindings[i].Capacity });
+		}
+
+		// Only the last binding of a set can have a variable count
+		bindingFlags.back() |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+			.bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+			.pBindingFlags = bindingFlags.data(),
+		};
+
+		VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+			.pNext = &bindingFlagsCreateInfo,
+			.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+			.bindingCount = static_cast<uint32_t>(layoutBindings.size()),
+			.pBindings = layoutBindings.data(),
+		};
+
+		if (vkCreateDescriptorSetLayout(device.VkDevice, &descriptorSetLayoutCreateInfo, nullptr, &g_DescriptorSetLayout) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create the bindless descriptor set layout!");
+			return;
+		}
+
+		VkDescriptorPoolCreateInfo descriptorPoolCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+			.maxSets = 1,
+			.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+			.pPoolSizes = poolSizes.data(),
+		};
+
+		if (vkCreateDescriptorPool(device.VkDevice, &descriptorPoolCreateInfo, nullptr, &g_DescriptorPool) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create the bindless descriptor pool!");
+			return;
+		}
+
+		uint32_t variableDescriptorCount = g_Bindings[BINDLESS_RESOURCE_TYPE_COUNT - 1].Capacity;
+		VkDescriptorSetVariableDescriptorCountAllocateInfo variableCountAllocateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
+			.descriptorSetCount = 1,
+			.pDescriptorCounts = &variableDescriptorCount,
+		};
+
+		VkDescriptorSetAllocateInfo descriptorSetAllocateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.pNext = &variableCountAllocateInfo,
+			.descriptorPool = g_DescriptorPool,
+			.descriptorSetCount = 1,
+			.pSetLayouts = &g_DescriptorSetLayout,
+		};
+
+		if (vkAllocateDescriptorSets(device.VkDevice, &descriptorSetAllocateInfo, &g_DescriptorSet) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to allocate the bindless descriptor set!");
+			return;
+		}
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device.VkPhysicalDevice, &properties);
+
+		VkPushConstantRange pushConstantRange
+		{
+			.stageFlags = VK_SHADER_STAGE_ALL,
+			.offset = 0,
+			.size = std::min(s_MaxPushConstantsSize, properties.limits.maxPushConstantsSize),
+		};
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.setLayoutCount = 1,
+			.pSetLayouts = &g_DescriptorSetLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange,
+		};
+
+		if (vkCreatePipelineLayout(device.VkDevice, &pipelineLayoutCreateInfo, nullptr, &g_PipelineLayout) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create the bindless pipeline layout!");
+			return;
+		}
+
+		g_Enabled = true;
+
+		PXL8_CORE_TRACE("Bindless descriptor heap created with " + std::to_string(g_Bindings[0].Capacity) + " sampled images, "
+			+ std::to_string(g_Bindings[1].Capacity) + " storage images and " + std::to_string(g_Bindings[2].Capacity) + " storage buffers.");
+	}
+
+	bool IsEnabled()
+	{
+		return g_Enabled;
+	}
+
+	// Expects g_Mutex to be held
+	static BindlessIndex AllocateIndex(HeapBinding& binding)
+	{
+		while (!binding.RetiredIndices.empty() && TimelineManager::IsComplete(binding.RetiredIndices.front().RetireAfter))
+		{
+			binding.FreeIndices.push_back(binding.RetiredIndices.front().Index);
+			binding.RetiredIndices.pop_front();
+		}
+
+		if (!binding.FreeIndices.empty())
+		{
+			BindlessIndex index = binding.FreeIndices.back();
+			binding.FreeIndices.pop_back();
+			return index;
+		}
+
+		if (binding.Next < binding.Capacity)
+			return binding.Next++;
+
+		return INVALID_BINDLESS_INDEX;
+	}
+
+	static BindlessIndex Register(BindlessResourceType type, const VkDescriptorImageInfo* pImageInfo, const VkDescriptorBufferInfo* pBufferInfo)
+	{
+		if (!g_Enabled)
+			return INVALID_BINDLESS_INDEX;
+
+		std::scoped_lock lock(g_Mutex);
+
+		uint32_t bindingIndex = static_cast<uint32_t>(type);
+		auto& binding = g_Bindings[bindingIndex];
+
+		BindlessIndex index = AllocateIndex(binding);
+		if (index == INVALID_BINDLESS_INDEX)
+		{
+			PXL8_CORE_ERROR("The bindless descriptor heap is out of slots for descriptor type " + std::to_string(binding.Type) + "!");
+			return INVALID_BINDLESS_INDEX;
+		}
+
+		// Update-after-bind, so the set may be in use by command buffers in flight
+		VkWriteDescriptorSet write
+		{
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = g_DescriptorSet,
+			.dstBinding = s_FirstResourceBinding + bindingIndex,
+			.dstArrayElement = index,
+			.descriptorCount = 1,
+			.descriptorType = binding.Type,
+			.pImageInfo = pImageInfo,
+			.pBufferInfo = pBufferInfo,
+		};
+		vkUpdateDescriptorSets(g_Device, 1, &write, 0, nullptr);
+
+		return index;
+	}
+
+	BindlessIndex RegisterSampledImage(VkImageView imageView, VkImageLayout layout)
+	{
+		VkDescriptorImageInfo imageInfo{ .imageView = imageView, .imageLayout = layout };
+		return Register(BindlessResourceType::SampledImage, &imageInfo, nullptr);
+	}
+
+	BindlessIndex RegisterStorageImage(VkImageView imageView)
+	{
+		VkDescriptorImageInfo imageInfo{ .imageView = imageView, .imageLayout = VK_IMAGE_LAYOUT_GENERAL };
+		return Register(BindlessResourceType::StorageImage, &imageInfo, nullptr);
+	}
+
+	BindlessIndex RegisterStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+	{
+		VkDescriptorBufferInfo bufferInfo{ .buffer = buffer, .offset = offset, .range = range };
+		return Register(BindlessResourceType::StorageBuffer, nullptr, &bufferInfo);
+	}
+
+	void Release(BindlessResourceType type, BindlessIndex index, TimelinePoint retireAfter)
+	{
+		if (!g_Enabled || index == INVALID_BINDLESS_INDEX)
+			return;
+
+		std::scoped_lock lock(g_Mutex);
+
+		// Partially bound, so the stale descriptor can stay in the set until the slot is reused
+		g_Bindings[static_cast<uint32_t>(type)].RetiredIndices.push_back(RetiredIndex{ retireAfter, index });
+	}
+
+	VkDescriptorSetLayout GetDescriptorSetLayout()
+	{
+		return g_DescriptorSetLayout;
+	}
+
+	VkPipelineLayout GetPipelineLayout()
+	{
+		return g_PipelineLayout;
+	}
+
+	void Bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint)
+	{
+		if (!g_Enabled)
+			return;
+
+		vkCmdBindDescriptorSets(commandBuffer, bindPoint, g_PipelineLayout, 0, 1, &g_DescriptorSet, 0, nullptr);
+	}
+
+	void Dispose(VkDevice device)
+	{
+		if (g_PipelineLayout != VK_NULL_HANDLE)
+			vkDestroyPipelineLayout(device, g_PipelineLayout, nullptr);
+
+		// Frees the set as well
+		if (g_DescriptorPool != VK_NULL_HANDLE)
+			vkDestroyDescriptorPool(device, g_DescriptorPool, nullptr);
+
+		if (g_DescriptorSetLayout != VK_NULL_HANDLE)
+			vkDestroyDescriptorSetLayout(device, g_DescriptorSetLayout, nullptr);
+
+		for (auto& sampler : g_Samplers)
+		{
+			if (sampler != VK_NULL_HANDLE)
+				vkDestroySampler(device, sampler, nullptr);
+			sampler = VK_NULL_HANDLE;
+		}
+
+		g_PipelineLayout = VK_NULL_HANDLE;
+		g_DescriptorPool = VK_NULL_HANDLE;
+		g_DescriptorSet = VK_NULL_HANDLE;
+		g_DescriptorSetLayout = VK_NULL_HANDLE;
+		for (auto& binding : g_Bindings)
+			binding = HeapBinding{};
+		g_Enabled = false;
+
+		PXL8_CORE_TRACE("Bindless descriptor heap disposed successfully.");
+	}
+}
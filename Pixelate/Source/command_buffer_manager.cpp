@@ -1,25 +1,13 @@
-#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "command_buffer_manager.h"
-#include "hasher.h"
-#include "thread_safe_fifo_queue.h"
+#include "pixelate_settings.h"
+#include "log.h"
+#include "cpu_profiler.h"
 
 namespace Pixelate
 {
-	uint64_t CommandBufferDescriptor::Hash(VkDevice device)
-	{
-		auto threadId = std::this_thread::get_id();
-
-		Hasher hasher;
-
-		hasher.Hash(std::hash<std::thread::id>()(threadId));
-		hasher.Hash((uint32_t)Type);
-		hasher.Hash((uint32_t)Level);
-		hasher.Hash((uint32_t)PerformanceProfile);
-		hasher.Hash((uint32_t)device);
-
-		return hasher.GetValue();
-	}
-
 	void PixelateVkCommandBuffer::Return()
 	{
 		CommandBufferManager::ReturnCommandBuffer(Device, CommandBuffer, Descriptor);
@@ -28,10 +16,38 @@ namespace Pixelate
 
 namespace Pixelate::CommandBufferManager
 {
-	std::unordered_map<uint64_t, VkCommandPool> g_CommandPools;
-	std::unordered_map<uint64_t, ThreadSafeFifoQueue<VkCommandBuffer>> g_CommandBuffers;
-	uint32_t g_LastCommandBufferAllocationCount = 8;
+	static constexpr uint32_t s_InitialCommandBufferAllocationCount = 4;
 	static constexpr uint32_t s_CommandBufferGrowthRate = 2;
+	static constexpr uint32_t s_CommandBufferLevelCount = 2; // primary, secondary
+
+	// Bump allocator over the command buffers of one pool, rewound when the pool is reset
+	struct CommandPoolArena
+	{
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> CommandBuffers[s_CommandBufferLevelCount]{};
+		size_t NextCommandBuffer[s_CommandBufferLevelCount]{};
+	};
+
+	struct PersistentCommandPool
+	{
+		VkCommandPool CommandPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> FreeCommandBuffers[s_CommandBufferLevelCount]{};
+	};
+
+	// Owned by one recording thread, only touched by others in ResetFrame and Dispose while that thread isn't recording
+	struct ThreadCommandPools
+	{
+		VkDevice Device = VK_NULL_HANDLE;
+		CommandPoolArena FrameArenas[COMMAND_BUFFER_TYPE_COUNT][PixelateSettings::MAX_FRAMES_IN_FLIGHT]{};
+		PersistentCommandPool PersistentPools[COMMAND_BUFFER_TYPE_COUNT]{};
+	};
+
+	std::mutex g_ThreadCommandPoolsMutex; // taken on a thread's first use, once per frame reset and on dispose
+	std::vector<std::unique_ptr<ThreadCommandPools>> g_ThreadCommandPools;
+	std::atomic<uint64_t> g_ThreadCommandPoolsGeneration = 1; // bumped on dispose so threads don't keep dangling pools
+
+	thread_local ThreadCommandPools* t_CommandPools = nullptr;
+	thread_local uint64_t t_CommandPoolsGeneration = 0;
 
 	static inline uint32_t GetQueueFamilyIndexFromBufferType(CommandBufferType type, QueueFamilyIndices queueFamilyIndices)
 	{
@@ -46,22 +62,24 @@ namespace Pixelate::CommandBufferManager
 		return std::numeric_limits<uint32_t>::max();
 	}
 
-	static void AllocateCommandPool(VkDevice device, QueueFamilyIndices queueFamilyIndices, CommandBufferType type, VkCommandPool* commandPool)
+	static VkCommandPool AllocateCommandPool(PixelateDevice device, CommandBufferType type, VkCommandPoolCreateFlags flags)
 	{
-		uint32_t queueFamilyIndex = GetQueueFamilyIndexFromBufferType(type, queueFamilyIndices);
-
 		VkCommandPoolCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		createInfo.queueFamilyIndex = queueFamilyIndex;
-		createInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		createInfo.queueFamilyIndex = GetQueueFamilyIndexFromBufferType(type, device.QueueFamilyIndices);
+		createInfo.flags = flags;
+
+		VkCommandPool commandPool = VK_NULL_HANDLE;
+		if (vkCreateCommandPool(device.VkDevice, &createInfo, nullptr, &commandPool) != VK_SUCCESS)
+			PXL8_CORE_ERROR("Failed to create command pool!");
 
-		vkCreateCommandPool(device, &createInfo, nullptr, commandPool);
+		return commandPool;
 	}
 
 	static std::vector<VkCommandBuffer> AllocateCommandBuffers(VkDevice device, VkCommandPool commandPool, VkCommandBufferLevel level, uint32_t count)
 	{
 		std::vector<VkCommandBuffer> newCommandBuffers(count);
-		
+
 		VkCommandBufferAllocateInfo allocationInfo{};
 		allocationInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocationInfo.commandBufferCount = count;
@@ -73,40 +91,119 @@ namespace Pixelate::CommandBufferManager
 		return newCommandBuffers;
 	}
 
-	PixelateVkCommandBuffer CommandBufferManager::GetCommandBuffer(PixelateDevice device, CommandBufferDescriptor descriptor)
+	static ThreadCommandPools& GetThreadCommandPools(VkDevice device)
+	{
+		if (t_CommandPools != nullptr && t_CommandPoolsGeneration == g_ThreadCommandPoolsGeneration.load(std::memory_order_acquire))
+			return *t_CommandPools;
+
+		std::lock_guard<std::mutex> lock(g_ThreadCommandPoolsMutex);
+
+		auto& commandPools = g_ThreadCommandPools.emplace_back(std::make_unique<ThreadCommandPools>());
+		commandPools->Device = device;
+
+		t_CommandPools = commandPools.get();
+		t_CommandPoolsGeneration = g_ThreadCommandPoolsGeneration.load(std::memory_order_relaxed);
+
+		return *t_CommandPools;
+	}
+
+	static uint32_t GetGrowthCount(size_t currentCount)
+	{
+		return currentCount == 0
+			? s_InitialCommandBufferAllocationCount
+			: static_cast<uint32_t>(currentCount * (s_CommandBufferGrowthRate - 1));
+	}
+
+	VkCommandBuffer GetFrameCommandBuffer(PixelateDevice device, uint32_t frameInFlightIndex, CommandBufferDescriptor descriptor)
 	{
-		auto poolHash = descriptor.Hash(device.VkDevice);
+		PXL8_PROFILE_SCOPE("CommandBufferManager::GetFrameCommandBuffer");
 
-		if (g_CommandBuffers.find(poolHash) != g_CommandBuffers.end())
+		auto& arena = GetThreadCommandPools(device.VkDevice).FrameArenas[(uint32_t)descriptor.Type][frameInFlightIndex];
+
+		// Everything in the pool is reset at once, so it doesn't need per-buffer resets
+		if (arena.CommandPool == VK_NULL_HANDLE)
+			arena.CommandPool = AllocateCommandPool(device, descriptor.Type, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+		auto& commandBuffers = arena.CommandBuffers[descriptor.Level];
+		auto& next = arena.NextCommandBuffer[descriptor.Level];
+
+		if (next == commandBuffers.size())
 		{
-			VkCommandBuffer commandBuffer{};
-			if (g_CommandBuffers[poolHash].try_pop(commandBuffer))
-				return { device.VkDevice, descriptor, commandBuffer };
+			auto newCommandBuffers = AllocateCommandBuffers(device.VkDevice, arena.CommandPool, descriptor.Level, GetGrowthCount(commandBuffers.size()));
+			commandBuffers.insert(commandBuffers.end(), newCommandBuffers.begin(), newCommandBuffers.end());
 		}
 
-		if (g_CommandPools.find(poolHash) == g_CommandPools.end())
+		return commandBuffers[next++];
+	}
+
+	void ResetFrame(VkDevice device, uint32_t frameInFlightIndex)
+	{
+		PXL8_PROFILE_SCOPE("CommandBufferManager::ResetFrame");
+
+		std::lock_guard<std::mutex> lock(g_ThreadCommandPoolsMutex);
+
+		for (auto& commandPools : g_ThreadCommandPools)
 		{
-			g_CommandPools.insert({ poolHash, VK_NULL_HANDLE });
-			AllocateCommandPool(device.VkDevice, device.QueueFamilyIndices, descriptor.Type, &g_CommandPools.at(poolHash));
+			for (auto& arenas : commandPools->FrameArenas)
+			{
+				auto& arena = arenas[frameInFlightIndex];
+
+				if (arena.CommandPool == VK_NULL_HANDLE)
+					continue;
+
+				vkResetCommandPool(device, arena.CommandPool, 0);
+
+				for (auto& next : arena.NextCommandBuffer)
+					next = 0;
+			}
 		}
+	}
+
+	PixelateVkCommandBuffer GetCommandBuffer(PixelateDevice device, CommandBufferDescriptor descriptor)
+	{
+		PXL8_PROFILE_SCOPE("CommandBufferManager::GetCommandBuffer");
+
+		auto& pool = GetThreadCommandPools(device.VkDevice).PersistentPools[(uint32_t)descriptor.Type];
+
+		// Re-recording implicitly resets a command buffer, which needs the reset bit on its pool
+		if (pool.CommandPool == VK_NULL_HANDLE)
+			pool.CommandPool = AllocateCommandPool(device, descriptor.Type, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+
+		auto& freeCommandBuffers = pool.FreeCommandBuffers[descriptor.Level];
 
-		auto bufferAllocationCount = g_LastCommandBufferAllocationCount * s_CommandBufferGrowthRate;
-		g_LastCommandBufferAllocationCount = bufferAllocationCount;
-		auto newCommandBuffers = AllocateCommandBuffers(device.VkDevice, g_CommandPools[poolHash], descriptor.Level, bufferAllocationCount);
+		if (freeCommandBuffers.empty())
+			freeCommandBuffers = AllocateCommandBuffers(device.VkDevice, pool.CommandPool, descriptor.Level, s_InitialCommandBufferAllocationCount);
 
-		g_CommandBuffers[poolHash].push_range(newCommandBuffers);
+		auto commandBuffer = freeCommandBuffers.back();
+		freeCommandBuffers.pop_back();
 
-		return { device.VkDevice, descriptor, g_CommandBuffers[poolHash].pop() };
+		return { device.VkDevice, descriptor, commandBuffer };
 	}
 
 	void ReturnCommandBuffer(VkDevice device, VkCommandBuffer commandBuffer, CommandBufferDescriptor descriptor)
 	{
-		auto resetFlags = descriptor.PerformanceProfile == CommandBufferPerformanceProfile::PersistentResources
-			? VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT
-			: 0;
+		// No reset here, the next vkBeginCommandBuffer resets it
+		GetThreadCommandPools(device).PersistentPools[(uint32_t)descriptor.Type].FreeCommandBuffers[descriptor.Level].push_back(commandBuffer);
+	}
+
+	void Dispose(VkDevice device)
+	{
+		std::lock_guard<std::mutex> lock(g_ThreadCommandPoolsMutex);
 
-		auto hash = descriptor.Hash(device);
-		vkResetCommandBuffer(commandBuffer, resetFlags);
-		g_CommandBuffers[hash].push(commandBuffer);
+		// Destroying a pool frees all of its command buffers
+		for (auto& commandPools : g_ThreadCommandPools)
+		{
+			for (auto& arenas : commandPools->FrameArenas)
+				for (auto& arena : arenas)
+					vkDestroyCommandPool(device, arena.CommandPool, nullptr);
+
+			for (auto& pool : commandPools->PersistentPools)
+				vkDestroyCommandPool(device, pool.CommandPool, nullptr);
+		}
+
+		g_ThreadCommandPools.clear();
+		g_ThreadCommandPoolsGeneration++;
+
+		PXL8_CORE_TRACE("Command pools disposed successfully.");
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,211 @@
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "cpu_profiler.h"
+#include "pixelate_helpers.h"
+#include "log.h"
+
+namespace Pixelate::CpuProfiler
+{
+	// Relaxed atomics, so a reader racing the writer on a slot reads a torn event instead of causing undefined behavior
+	struct EventSlot
+	{
+		std::atomic<const char*> Name = nullptr;
+		std::atomic<uint64_t> Start = 0;
+		std::atomic<uint64_t> End = 0;
+	};
+
+	// Single writer ring, readers copy a range and drop whatever the writer may have overwritten meanwhile
+	struct ThreadEventBuffer
+	{
+		uint32_t ThreadId = 0;
+		std::string ThreadName{};
+		std::unique_ptr<EventSlot[]> Events = std::make_unique<EventSlot[]>(EVENTS_PER_THREAD);
+		std::atomic<uint64_t> WriteIndex = 0;
+	};
+
+	std::atomic<bool> g_Enabled = false;
+	const auto g_Epoch = std::chrono::steady_clock::now();
+
+	std::mutex g_EventBuffersMutex; // taken on a thread's first event and on export
+	std::vector<std::unique_ptr<ThreadEventBuffer>> g_EventBuffers; // never shrinks, threads may exit while their events are still wanted
+
+	uint64_t g_FrameStarts[MAX_TRACKED_FRAMES]{};
+	std::atomic<uint64_t> g_FrameCount = 0;
+
+	thread_local ThreadEventBuffer* t_EventBuffer = nullptr;
+	thread_local const char* t_ThreadName = nullptr; // until the thread records its first event
+
+	static ThreadEventBuffer& GetThreadEventBuffer()
+	{
+		if (t_EventBuffer != nullptr)
+			return *t_EventBuffer;
+
+		std::lock_guard<std::mutex> lock(g_EventBuffersMutex);
+
+		auto& eventBuffer = g_EventBuffers.emplace_back(std::make_unique<ThreadEventBuffer>());
+		eventBuffer->ThreadId = static_cast<uint32_t>(g_EventBuffers.size());
+		eventBuffer->ThreadName = t_ThreadName != nullptr ? t_ThreadName : "Thread " + std::to_string(eventBuffer->ThreadId);
+
+		t_EventBuffer = eventBuffer.get();
+
+		return *t_EventBuffer;
+	}
+
+	void SetEnabled(bool enabled)
+	{
+		g_Enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	void SetThreadName(const char* name)
+	{
+		// Threads that never record an event never allocate a buffer
+		if (t_EventBuffer == nullptr)
+		{
+			t_ThreadName = name;
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(g_EventBuffersMutex);
+		t_EventBuffer->ThreadName = name;
+	}
+
+	uint64_t Now()
+	{
+		// Never 0, which marks scopes entered while the profiler was disabled
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_Epoch).count()) + 1;
+	}
+
+	void RecordEvent(const char* name, uint64_t start, uint64_t end)
+	{
+		auto& eventBuffer = GetThreadEventBuffer();
+		auto writeIndex = eventBuffer.WriteIndex.load(std::memory_order_relaxed);
+
+		// Keeps the slot's stores after the previous WriteIndex store, a reader that sees one of them also sees writeIndex
+		std::atomic_thread_fence(std::memory_order_release);
+
+		auto& slot = eventBuffer.Events[writeIndex & (EVENTS_PER_THREAD - 1)];
+		slot.Name.store(name, std::memory_order_relaxed);
+		slot.Start.store(start, std::memory_order_relaxed);
+		slot.End.store(end, std::memory_order_relaxed);
+		eventBuffer.WriteIndex.store(writeIndex + 1, std::memory_order_release);
+	}
+
+	void MarkFrame()
+	{
+		if (!IsEnabled())
+			return;
+
+		auto frameCount = g_FrameCount.load(std::memory_order_relaxed);
+		g_FrameStarts[frameCount % MAX_TRACKED_FRAMES] = Now();
+		g_FrameCount.store(frameCount + 1, std::memory_order_release);
+	}
+
+	static uint64_t GetFirstExportedTimestamp(uint32_t lastFrameCount)
+	{
+		auto frameCount = g_FrameCount.load(std::memory_order_acquire);
+
+		if (lastFrameCount == 0 || frameCount == 0)
+			return 0;
+
+		lastFrameCount = static_cast<uint32_t>(std::min<uint64_t>({ lastFrameCount, frameCount, MAX_TRACKED_FRAMES }));
+		return g_FrameStarts[(frameCount - lastFrameCount) % MAX_TRACKED_FRAMES];
+	}
+
+	static std::vector<CpuProfileEvent> CopyEvents(const ThreadEventBuffer& eventBuffer)
+	{
+		auto end = eventBuffer.WriteIndex.load(std::memory_order_acquire);
+		auto begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+
+		std::vector<CpuProfileEvent> events{};
+		events.reserve(end - begin);
+		for (auto i = begin; i < end; i++)
+		{
+			const auto& slot = eventBuffer.Events[i & (EVENTS_PER_THREAD - 1)];
+			events.push_back(CpuProfileEvent
+				{
+					slot.Name.load(std::memory_order_relaxed),
+					slot.Start.load(std::memory_order_relaxed),
+					slot.End.load(std::memory_order_relaxed)
+				});
+		}
+
+		// The writer kept going while copying, entries it has wrapped around to may be torn.
+		// That includes the slot of writeIndex itself, which the writer may be in the middle of before publishing writeIndex + 1.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		auto writeIndex = eventBuffer.WriteIndex.load(std::memory_order_relaxed);
+		auto firstIntact = writeIndex + 1 > EVENTS_PER_THREAD ? writeIndex + 1 - EVENTS_PER_THREAD : 0;
+		if (firstIntact > begin)
+			events.erase(events.begin(), events.begin() + std::min<size_t>(firstIntact - begin, events.size()));
+
+		return events;
+	}
+
+	static std::string EscapeJson(const std::string& value)
+	{
+		std::string escaped{};
+		escaped.reserve(value.size());
+
+		for (auto character : value)
+		{
+			if (character == '"' || character == '\\')
+				escaped.push_back('\\');
+			escaped.push_back(character);
+		}
+
+		return escaped;
+	}
+
+	std::string GetChromeTrace(uint32_t lastFrameCount)
+	{
+		auto firstTimestamp = GetFirstExportedTimestamp(lastFrameCount);
+
+		std::string trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		auto isFirstEvent = true;
+
+		auto appendEvent = [&](const std::string& event)
+		{
+			if (!isFirstEvent)
+				trace += ",\n";
+
+			trace += event;
+			isFirstEvent = false;
+		};
+
+		std::lock_guard<std::mutex> lock(g_EventBuffersMutex);
+
+		for (const auto& eventBuffer : g_EventBuffers)
+		{
+			auto threadId = std::to_string(eventBuffer->ThreadId);
+			appendEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" + threadId + ",\"args\":{\"name\":\"" + EscapeJson(eventBuffer->ThreadName) + "\"}}");
+
+			// Complete events, timestamps in microseconds
+			for (const auto& event : CopyEvents(*eventBuffer))
+			{
+				if (event.Start < firstTimestamp)
+					continue;
+
+				appendEvent("{\"name\":\"" + EscapeJson(event.Name) + "\",\"ph\":\"X\",\"pid\":0,\"tid\":" + threadId
+					+ ",\"ts\":" + std::to_string(event.Start / 1000.0)
+					+ ",\"dur\":" + std::to_string((event.End - event.Start) / 1000.0) + "}");
+			}
+		}
+
+		trace += "]}\n";
+
+		return trace;
+	}
+
+	bool ExportChromeTrace(const std::string& filepath, uint32_t lastFrameCount)
+	{
+		auto trace = GetChromeTrace(lastFrameCount);
+
+		if (!Helpers::WriteFileAtomic(filepath, trace.data(), trace.size()))
+			return false;
+
+		PXL8_CORE_INFO("CPU trace written to " + filepath + ".");
+
+		return true;
+	}
+}
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include "descriptor_allocator.h"
+#include "pixelate_settings.h"
+#include "log.h"
+#include "cpu_profiler.h"
+
+namespace Pixelate::DescriptorAllocator
+{
+	static constexpr uint32_t s_InitialSetsPerPool = 64;
+	static constexpr uint32_t s_MaxSetsPerPool = 4096; // chained pools double in size up to this
+
+	struct DescriptorRatio
+	{
+		VkDescriptorType Type;
+		float DescriptorsPerSet;
+	};
+
+	// Pool sizes relative to maxSets, generous for uniform data and images since that is what per-frame sets mostly hold
+	static constexpr DescriptorRatio s_DescriptorRatios[]
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+	};
+
+	// Bump allocator over a chain of pools, rewound to the first pool when the slot is reset
+	struct DescriptorPoolArena
+	{
+		std::vector<VkDescriptorPool> DescriptorPools{};
+		size_t CurrentPool = 0;
+	};
+
+	// Owned by one recording thread, only touched by others in ResetFrame and Dispose while that thread isn't recording
+	struct ThreadDescriptorPools
+	{
+		DescriptorPoolArena FrameArenas[PixelateSettings::MAX_FRAMES_IN_FLIGHT]{};
+	};
+
+	VkDevice g_Device = VK_NULL_HANDLE;
+	std::mutex g_ThreadDescriptorPoolsMutex; // taken on a thread's first use, once per frame reset and on dispose
+	std::vector<std::unique_ptr<ThreadDescriptorPools>> g_ThreadDescriptorPools;
+	std::atomic<uint64_t> g_ThreadDescriptorPoolsGeneration = 1; // bumped on dispose so threads don't keep dangling pools
+	std::atomic<uint64_t> g_AllocatedSetCount = 0;
+	std::atomic<uint32_t> g_PoolCount = 0;
+
+	thread_local ThreadDescriptorPools* t_DescriptorPools = nullptr;
+	thread_local uint64_t t_DescriptorPoolsGeneration = 0;
+
+	void Initialize(VkDevice device)
+	{
+		g_Device = device;
+	}
+
+	static ThreadDescriptorPools& GetThreadDescriptorPools()
+	{
+		if (t_DescriptorPools != nullptr && t_DescriptorPoolsGeneration == g_ThreadDescriptorPoolsGeneration.load(std::memory_order_acquire))
+			return *t_DescriptorPools;
+
+		std::lock_guard<std::mutex> lock(g_ThreadDescriptorPoolsMutex);
+
+		t_DescriptorPools = g_ThreadDescriptorPools.emplace_back(std::make_unique<ThreadDescriptorPools>()).get();
+		t_DescriptorPoolsGeneration = g_ThreadDescriptorPoolsGeneration.load(std::memory_order_relaxed);
+
+		return *t_DescriptorPools;
+	}
+
+	static VkDescriptorPool CreateDescriptorPool(uint32_t maxSets)
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes{};
+		for (const auto& ratio : s_DescriptorRatios)
+			poolSizes.push_back(VkDescriptorPoolSize{ ratio.Type, static_cast<uint32_t>(ratio.DescriptorsPerSet * maxSets) });
+
+		// No FREE_DESCRIPTOR_SET_BIT, sets only go away with the whole pool
+		VkDescriptorPoolCreateInfo createInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.flags = 0,
+			.maxSets = maxSets,
+			.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+			.pPoolSizes = poolSizes.data(),
+		};
+
+		VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+		if (vkCreateDescriptorPool(g_Device, &createInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create descriptor pool!");
+			return VK_NULL_HANDLE;
+		}
+
+		g_PoolCount.fetch_add(1, std::memory_order_relaxed);
+		PXL8_CORE_TRACE("Descriptor pool for " + std::to_string(maxSets) + " frame descriptor sets created.");
+
+		return descriptorPool;
+	}
+
+	VkDescriptorSet AllocateFrameSet(uint32_t frameInFlightIndex, VkDescriptorSetLayout layout)
+	{
+		PXL8_PROFILE_SCOPE("DescriptorAllocator::AllocateFrameSet");
+
+		auto& arena = GetThreadDescriptorPools().FrameArenas[frameInFlightIndex];
+
+		// Moves along the chain until a pool has room, a set that doesn't fit an empty pool never will
+		bool isFreshPool = false;
+		while (true)
+		{
+			if (arena.CurrentPool == arena.DescriptorPools.size())
+			{
+				auto maxSets = s_InitialSetsPerPool;
+				for (size_t i = 0; i < arena.DescriptorPools.size() && maxSets < s_MaxSetsPerPool; i++)
+					maxSets *= 2;
+
+				auto descriptorPool = CreateDescriptorPool(maxSets);
+				if (descriptorPool == VK_NULL_HANDLE)
+					return VK_NULL_HANDLE;
+
+				arena.DescriptorPools.push_back(descriptorPool);
+				isFreshPool = true;
+			}
+
+			VkDescriptorSetAllocateInfo allocateInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+				.descriptorPool = arena.DescriptorPools[arena.CurrentPool],
+				.descriptorSetCount = 1,
+				.pSetLayouts = &layout,
+			};
+
+			VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+			auto result = vkAllocateDescriptorSets(g_Device, &allocateInfo, &descriptorSet);
+
+			if (result == VK_SUCCESS)
+			{
+				g_AllocatedSetCount.fetch_add(1, std::memory_order_relaxed);
+				return descriptorSet;
+			}
+
+			if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || isFreshPool)
+			{
+				PXL8_CORE_ERROR("Failed to allocate a frame descriptor set!");
+				return VK_NULL_HANDLE;
+			}
+
+			// The pool is full, chain the next one. Pools reused after a reset are empty as well.
+			arena.CurrentPool++;
+			isFreshPool = arena.CurrentPool < arena.DescriptorPools.size();
+		}
+	}
+
+	void ResetFrame(uint32_t frameInFlightIndex)
+	{
+		PXL8_PROFILE_SCOPE("DescriptorAllocator::ResetFrame");
+
+		std::lock_guard<std::mutex> lock(g_ThreadDescriptorPoolsMutex);
+
+		for (auto& descriptorPools : g_ThreadDescriptorPools)
+		{
+			auto& arena = descriptorPools->FrameArenas[frameInFlightIndex];
+
+			// Only the pools up to the current one were allocated from
+			for (size_t i = 0; i < arena.DescriptorPools.size() && i <= arena.CurrentPool; i++)
+				vkResetDescriptorPool(g_Device, arena.DescriptorPools[i], 0);
+
+			arena.CurrentPool = 0;
+		}
+	}
+
+	DescriptorAllocatorStatistics GetStatistics()
+	{
+		return DescriptorAllocatorStatistics
+		{
+			.AllocatedSetCount = g_AllocatedSetCount.load(std::memory_order_relaxed),
+			.PoolCount = g_PoolCount.load(std::memory_order_relaxed),
+		};
+	}
+
+	void Dispose()
+	{
+		std::lock_guard<std::mutex> lock(g_ThreadDescriptorPoolsMutex);
+
+		if (g_AllocatedSetCount > 0)
+			PXL8_CORE_INFO(std::to_string(g_AllocatedSetCount.load()) + " frame descriptor sets were allocated from " + std::to_string(g_PoolCount.load()) + " descriptor pools.");
+
+		// Destroying a pool frees all of its sets
+		for (auto& descriptorPools : g_ThreadDescriptorPools)
+			for (auto& arena : descriptorPools->FrameArenas)
+				for (auto descriptorPool : arena.DescriptorPools)
+					vkDestroyDescriptorPool(g_Device, descriptorPool, nullptr);
+
+		g_ThreadDescriptorPools.clear();
+		g_ThreadDescriptorPoolsGeneration++;
+		g_AllocatedSetCount = 0;
+		g_PoolCount = 0;
+
+		PXL8_CORE_TRACE("Descriptor pools disposed successfully.");
+	}
+}
@@ -1,6 +1,7 @@
 #include "fence_manager.h"
 #include "hasher.h"
 #include "log.h"
+#include "cpu_profiler.h"
 
 namespace Pixelate
 {
@@ -22,6 +23,8 @@ namespace Pixelate
 
 	void FenceGroup::Wait(uint32_t index, uint64_t timeout)
 	{
+		PXL8_PROFILE_SCOPE("FenceGroup::Wait");
+
 		if (index == std::numeric_limits<uint32_t>::max())
 		{
 			vkWaitForFences(m_Device, m_VkFences.size(), m_VkFences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max());
@@ -0,0 +1,111 @@
+#include "frame_pacer.h"
+#include "command_buffer_manager.h"
+#include "descriptor_allocator.h"
+#include "uniform_ring.h"
+#include "queue_manager.h"
+#include "log.h"
+#include "cpu_profiler.h"
+
+namespace Pixelate
+{
+	static double ToMilliseconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	static void LogStatistics(const FramePacingStatistics& statistics)
+	{
+		PXL8_CORE_INFO(
+			"Frame pacing over " + std::to_string(statistics.FrameCount) + " frames:"
+			+ " frame time min/avg/max " + std::to_string(statistics.FrameTimeMin)
+			+ "/" + std::to_string(statistics.AverageFrameTime())
+			+ "/" + std::to_string(statistics.FrameTimeMax) + " ms,"
+			+ " fence wait avg " + std::to_string(statistics.AverageFenceWait()) + " ms,"
+			+ " CPU/GPU overlap " + std::to_string(statistics.CpuGpuOverlap() * 100.0) + "%");
+	}
+
+	FramePacer::FramePacer(PixelateDevice device) : m_Device(device)
+	{}
+
+	PixelateFrame FramePacer::BeginFrame(PixelatePresentationEngine& presentation)
+	{
+		PXL8_PROFILE_SCOPE("FramePacer::BeginFrame");
+
+		auto frameStart = Clock::now();
+
+		if (m_SerializeFrames)
+			QueueManager::DeviceWaitIdle(m_Device.VkDevice);
+
+		// Only blocks if the GPU is still working on the frame that last used this frame-in-flight slot
+		TimelineManager::Wait(m_FrameCompletePoints[m_FrameInFlightIndex]);
+
+		// The GPU is done with everything recorded for this slot, recycle all of it at once
+		CommandBufferManager::ResetFrame(m_Device.VkDevice, m_FrameInFlightIndex);
+		DescriptorAllocator::ResetFrame(m_FrameInFlightIndex);
+		UniformRing::ResetFrame(m_FrameInFlightIndex);
+
+		m_LastFenceWait = ToMilliseconds(Clock::now() - frameStart);
+
+		auto& acquireSwapchainImageSemaphore = SemaphoreManager::GetSemaphore(
+			m_Device.VkDevice,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+			SemaphoreDescriptor{
+				SemaphoreIdentifier::SwapchainImageHasBeenAcquired,
+				m_FrameInFlightIndex,
+			});
+
+		auto swapchainImageIndex = presentation.AcquireSwapcahinImage(acquireSwapchainImageSemaphore);
+
+		// Out of date, nothing was acquired and no timeline value is reserved, the slot is begun again after the recreation
+		if (swapchainImageIndex == INVALID_SWAPCHAIN_IMAGE_INDEX)
+			return PixelateFrame
+			{
+				.FrameInFlightIndex = m_FrameInFlightIndex,
+				.SwapchainImageIndex = INVALID_SWAPCHAIN_IMAGE_INDEX,
+				.ImageAcquiredSemaphore = acquireSwapchainImageSemaphore,
+				.FrameComplete = m_FrameCompletePoints[m_FrameInFlightIndex],
+			};
+
+		m_FrameCompletePoints[m_FrameInFlightIndex] = TimelineManager::Reserve(TimelineQueue::Graphics);
+
+		RecordFrameTime(frameStart);
+
+		return PixelateFrame
+		{
+			.FrameInFlightIndex = m_FrameInFlightIndex,
+			.SwapchainImageIndex = swapchainImageIndex,
+			.ImageAcquiredSemaphore = acquireSwapchainImageSemaphore,
+			.FrameComplete = m_FrameCompletePoints[m_FrameInFlightIndex],
+		};
+	}
+
+	void FramePacer::EndFrame()
+	{
+		m_FrameInFlightIndex = (m_FrameInFlightIndex + 1) % PixelateSettings::MAX_FRAMES_IN_FLIGHT;
+	}
+
+	void FramePacer::RecordFrameTime(Clock::time_point frameStart)
+	{
+		auto isFirstFrame = m_LastFrameStart == Clock::time_point{};
+		auto frameTime = ToMilliseconds(frameStart - m_LastFrameStart);
+		m_LastFrameStart = frameStart;
+
+		if (isFirstFrame)
+			return; // no previous frame to measure against
+
+		for (auto statistics : { &m_Statistics, &m_IntervalStatistics })
+		{
+			statistics->FrameCount++;
+			statistics->FrameTimeMin = std::min(statistics->FrameTimeMin, frameTime);
+			statistics->FrameTimeMax = std::max(statistics->FrameTimeMax, frameTime);
+			statistics->FrameTimeSum += frameTime;
+			statistics->FenceWaitSum += m_LastFenceWait;
+		}
+
+		if (m_IntervalStatistics.FrameCount >= PixelateSettings::FRAME_STATISTICS_LOG_INTERVAL)
+		{
+			LogStatistics(m_IntervalStatistics);
+			m_IntervalStatistics = FramePacingStatistics{};
+		}
+	}
+}
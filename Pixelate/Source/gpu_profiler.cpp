@@ -0,0 +1,148 @@
+#include "gpu_profiler.h"
+#include "pixelate_settings.h"
+#include "log.h"
+
+namespace Pixelate::GpuProfiler
+{
+	static constexpr uint32_t s_QueriesPerPass = 2; // begin, end
+
+	VkDevice g_Device = VK_NULL_HANDLE;
+	VkQueryPool g_QueryPools[PixelateSettings::MAX_FRAMES_IN_FLIGHT]{};
+	double g_TimestampPeriod = 0.0; // nanoseconds per tick
+	uint64_t g_TimestampMask = 0; // of the queue with the fewest valid bits, so differences wrap the same on every queue
+	bool g_TimedQueues[TIMELINE_QUEUE_COUNT]{};
+	std::vector<uint64_t> g_QueryResults{}; // value and availability per query
+
+	void Initialize(PixelateDevice device)
+	{
+		g_Device = device.VkDevice;
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device.VkPhysicalDevice, &properties);
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.VkPhysicalDevice, &queueFamilyCount, nullptr);
+
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.VkPhysicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		auto validBits = queueFamilies[device.QueueFamilyIndices.GraphicsQueueFamily.value()].timestampValidBits;
+
+		if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+		{
+			PXL8_CORE_WARN("Graphics queue doesn't support timestamps, GPU pass timings are disabled.");
+			return;
+		}
+
+		g_TimedQueues[static_cast<uint32_t>(TimelineQueue::Graphics)] = true;
+
+		// Passes on the async compute queue stay untimed if its family can't write timestamps
+		if (device.QueueFamilyIndices.HasAsyncCompute())
+		{
+			auto computeValidBits = queueFamilies[device.QueueFamilyIndices.ComputeQueueFamily.value()].timestampValidBits;
+			g_TimedQueues[static_cast<uint32_t>(TimelineQueue::Compute)] = computeValidBits != 0;
+
+			if (computeValidBits != 0)
+				validBits = std::min(validBits, computeValidBits);
+		}
+		else
+			g_TimedQueues[static_cast<uint32_t>(TimelineQueue::Compute)] = true;
+
+		g_TimestampPeriod = properties.limits.timestampPeriod;
+		g_TimestampMask = validBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << validBits) - 1;
+
+		VkQueryPoolCreateInfo createInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+			.queryType = VK_QUERY_TYPE_TIMESTAMP,
+			.queryCount = MAX_TIMED_PASSES * s_QueriesPerPass,
+		};
+
+		for (auto& queryPool : g_QueryPools)
+			if (vkCreateQueryPool(g_Device, &createInfo, nullptr, &queryPool) != VK_SUCCESS)
+				PXL8_CORE_ERROR("Failed to create timestamp query pool!");
+
+		PXL8_CORE_TRACE("GPU timestamp query pools created successfully.");
+	}
+
+	bool IsEnabled()
+	{
+		return g_QueryPools[0] != VK_NULL_HANDLE;
+	}
+
+	void BeginPass(VkCommandBuffer commandBuffer, uint32_t frameInFlightIndex, uint32_t passIndex, TimelineQueue queue)
+	{
+		if (!IsEnabled() || passIndex >= MAX_TIMED_PASSES)
+			return;
+
+		// Query commands on the same query execute in submission order, the reset needs no barrier.
+		// Untimed queues still reset, so the pass reads as unavailable instead of as a stale time.
+		auto firstQuery = passIndex * s_QueriesPerPass;
+		vkCmdResetQueryPool(commandBuffer, g_QueryPools[frameInFlightIndex], firstQuery, s_QueriesPerPass);
+
+		if (g_TimedQueues[static_cast<uint32_t>(queue)])
+			vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_NONE, g_QueryPools[frameInFlightIndex], firstQuery);
+	}
+
+	void EndPass(VkCommandBuffer commandBuffer, uint32_t frameInFlightIndex, uint32_t passIndex, TimelineQueue queue)
+	{
+		if (!IsEnabled() || passIndex >= MAX_TIMED_PASSES || !g_TimedQueues[static_cast<uint32_t>(queue)])
+			return;
+
+		vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, g_QueryPools[frameInFlightIndex], passIndex * s_QueriesPerPass + 1);
+	}
+
+	void ReadPassTimes(uint32_t frameInFlightIndex, uint32_t passCount, std::vector<double>& passTimes)
+	{
+		passTimes.assign(passCount, -1.0);
+
+		passCount = std::min(passCount, MAX_TIMED_PASSES);
+		if (!IsEnabled() || passCount == 0)
+			return;
+
+		auto queryCount = passCount * s_QueriesPerPass;
+		g_QueryResults.resize(queryCount * 2);
+
+		// VK_NOT_READY only means some queries are unavailable, the available ones are still written
+		auto result = vkGetQueryPoolResults(
+			g_Device,
+			g_QueryPools[frameInFlightIndex],
+			0,
+			queryCount,
+			g_QueryResults.size() * sizeof(uint64_t),
+			g_QueryResults.data(),
+			2 * sizeof(uint64_t),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+		{
+			PXL8_CORE_ERROR("Failed to read timestamp queries!");
+			return;
+		}
+
+		for (uint32_t i = 0; i < passCount; i++)
+		{
+			auto pBegin = &g_QueryResults[i * s_QueriesPerPass * 2];
+			auto pEnd = pBegin + 2;
+
+			if (pBegin[1] == 0 || pEnd[1] == 0)
+				continue; // not available
+
+			auto ticks = ((pEnd[0] - pBegin[0]) & g_TimestampMask);
+			passTimes[i] = ticks * g_TimestampPeriod / 1.0e6;
+		}
+	}
+
+	void Dispose()
+	{
+		for (auto& queryPool : g_QueryPools)
+		{
+			if (queryPool != VK_NULL_HANDLE)
+				vkDestroyQueryPool(g_Device, queryPool, nullptr);
+
+			queryPool = VK_NULL_HANDLE;
+		}
+
+		g_Device = VK_NULL_HANDLE;
+	}
+}
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <vector>
+#include "hasher.h"
+#include "log.h"
+
+namespace Pixelate::Hashers
+{
+	// The byte-wise FNV-1a Hasher used before, kept as the benchmark baseline
+	static uint64_t HashFnv1a(const char* ptr, size_t size)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ ptr[i]) * 0x100000001b3ull;
+
+		return hash;
+	}
+
+	static uint64_t HashWords(const char* ptr, size_t size)
+	{
+		Hasher hasher;
+		hasher.Hash(ptr, size);
+		return hasher.GetValue();
+	}
+
+	template<typename THashFunction>
+	static double MeasureNanosecondsPerHash(THashFunction hashFunction, const std::vector<char>& data, size_t size, uint32_t iterations)
+	{
+		volatile uint64_t sink = 0; // keeps the loop from being optimized away
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < iterations; i++)
+			sink = sink + hashFunction(data.data() + (i & 7), size); // vary the alignment like real descriptors
+
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+	}
+
+	void LogBenchmark()
+	{
+		// A handle or small key, a semaphore/fence descriptor, a Vulkan create info struct, a full graphics pipeline descriptor
+		constexpr size_t sizes[] = { 8, 16, 64, 512 };
+		constexpr uint32_t iterations = 1 << 20;
+
+		std::vector<char> data(sizes[std::size(sizes) - 1] + 8);
+		for (size_t i = 0; i < data.size(); i++)
+			data[i] = static_cast<char>(i * 31 + 7);
+
+		PXL8_CORE_INFO("Hasher benchmark, " + std::to_string(iterations) + " hashes per size (FNV-1a vs. word-at-a-time):");
+
+		for (auto size : sizes)
+		{
+			auto fnvTime = MeasureNanosecondsPerHash(HashFnv1a, data, size, iterations);
+			auto wordTime = MeasureNanosecondsPerHash(HashWords, data, size, iterations);
+
+			PXL8_CORE_INFO("    " + std::to_string(size) + " bytes: "
+				+ std::to_string(fnvTime) + " ns vs. " + std::to_string(wordTime) + " ns, "
+				+ std::to_string(fnvTime / wordTime) + "x");
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#include "pipeline_cache.h"
+#include "pixelate_helpers.h"
+#include "log.h"
+
+namespace Pixelate::PipelineCache
+{
+	VkPipelineCache g_PipelineCache = VK_NULL_HANDLE;
+	std::string g_PipelineCacheFilepath{};
+
+	static bool ValidatePipelineCacheHeader(VkPhysicalDevice physicalDevice, const std::vector<char>& cacheData)
+	{
+		if (cacheData.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+		{
+			PXL8_CORE_WARN("Pipeline cache on disk is truncated, discarding it.");
+			return false;
+		}
+
+		VkPipelineCacheHeaderVersionOne header{};
+		memcpy(&header, cacheData.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+		VkPhysicalDeviceProperties deviceProperties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+		if (header.headerSize < sizeof(VkPipelineCacheHeaderVersionOne)
+			|| header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+		{
+			PXL8_CORE_WARN("Pipeline cache on disk has an unknown header version, discarding it.");
+			return false;
+		}
+
+		if (header.vendorID != deviceProperties.vendorID
+			|| header.deviceID != deviceProperties.deviceID
+			|| memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			PXL8_CORE_WARN("Pipeline cache on disk was created by a different device or driver, discarding it.");
+			return false;
+		}
+
+		return true;
+	}
+
+	void Initialize(PixelateDevice device, const std::string& filepath)
+	{
+		g_PipelineCacheFilepath = filepath;
+
+		std::vector<char> cacheData{};
+
+		if (Helpers::FileExists(filepath))
+		{
+			cacheData = Helpers::ReadFile(filepath);
+
+			if (!ValidatePipelineCacheHeader(device.VkPhysicalDevice, cacheData))
+				cacheData.clear();
+		}
+
+		VkPipelineCacheCreateInfo createInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			.initialDataSize = cacheData.size(),
+			.pInitialData = cacheData.empty() ? nullptr : cacheData.data(),
+		};
+
+		auto result = vkCreatePipelineCache(device.VkDevice, &createInfo, nullptr, &g_PipelineCache);
+
+		if (result != VK_SUCCESS && !cacheData.empty())
+		{
+			PXL8_CORE_WARN("Driver rejected the pipeline cache on disk, starting with an empty cache.");
+			createInfo.initialDataSize = 0;
+			createInfo.pInitialData = nullptr;
+			result = vkCreatePipelineCache(device.VkDevice, &createInfo, nullptr, &g_PipelineCache);
+		}
+
+		if (result != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create pipeline cache!");
+			g_PipelineCache = VK_NULL_HANDLE;
+			return;
+		}
+
+		if (cacheData.empty())
+			PXL8_CORE_INFO("Pipeline cache is cold, pipelines will be compiled from scratch.");
+		else
+			PXL8_CORE_INFO("Pipeline cache is warm, loaded " + std::to_string(cacheData.size()) + " bytes from: " + filepath);
+	}
+
+	VkPipelineCache GetVkPipelineCache()
+	{
+		return g_PipelineCache;
+	}
+
+	void Save(VkDevice device)
+	{
+		if (g_PipelineCache == VK_NULL_HANDLE || g_PipelineCacheFilepath.empty())
+			return;
+
+		size_t cacheSize = 0;
+		vkGetPipelineCacheData(device, g_PipelineCache, &cacheSize, nullptr);
+
+		std::vector<char> cacheData(cacheSize);
+		auto result = vkGetPipelineCacheData(device, g_PipelineCache, &cacheSize, cacheData.data());
+
+		if (result != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to retrieve pipeline cache data!");
+			return;
+		}
+
+		if (Helpers::WriteFileAtomic(g_PipelineCacheFilepath, cacheData.data(), cacheSize))
+			PXL8_CORE_TRACE("Pipeline cache saved (" + std::to_string(cacheSize) + " bytes).");
+	}
+
+	void Dispose(VkDevice device)
+	{
+		Save(device);
+
+		vkDestroyPipelineCache(device, g_PipelineCache, nullptr);
+		g_PipelineCache = VK_NULL_HANDLE;
+	}
+}
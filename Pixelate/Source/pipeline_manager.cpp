@@ -1,37 +1,122 @@
+#include <algorithm>
+#include <functional>
 #include "pipeline_manager.h"
 #include "log.h"
 #include "hasher.h"
 #include "pixelate_helpers.h"
+#include "pipeline_cache.h"
+#include "shader_module_cache.h"
+#include "bindless_descriptors.h"
+#include "worker_pool.h"
+#include "cpu_profiler.h"
 
 namespace Pixelate
 {
 	namespace Pipelines
 	{
-		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts(VkDevice device, const GraphicsPipelineDescriptor& descriptor)
+		// Content-addressed, so passes with equal layouts get the same handles and their bound sets and push constants
+		// stay valid across pipeline switches. Owned by the cache and destroyed in Dispose.
+		std::unordered_map<uint64_t, VkDescriptorSetLayout> g_DescriptorSetLayouts{};
+		std::unordered_map<uint64_t, VkPipelineLayout> g_PipelineLayouts{};
+		std::mutex g_LayoutsMutex;
+		uint32_t g_LayoutRequestCount = 0; // guarded by g_LayoutsMutex
+
+		// Expects the bindings sorted by binding number
+		static uint64_t GetDescriptorSetLayoutKey(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
 		{
-			std::vector<VkDescriptorSetLayout> descriptorSetLayouts{};
-			descriptorSetLayouts.reserve(descriptor.DescriptorSetLayoutBindings.size());
+			Hasher hasher;
+			hasher.Hash((uint64_t)bindings.size());
+			for (const auto& binding : bindings)
+			{
+				hasher.Hash(binding.binding);
+				hasher.Hash((uint32_t)binding.descriptorType);
+				hasher.Hash(binding.descriptorCount);
+				hasher.Hash((uint32_t)binding.stageFlags);
+
+				if (binding.pImmutableSamplers != nullptr)
+					for (uint32_t i = 0; i < binding.descriptorCount; i++)
+						hasher.Hash(reinterpret_cast<uint64_t>(binding.pImmutableSamplers[i]));
+			}
+
+			return hasher.GetValue();
+		}
 
-			for (auto& descriptorBinding : descriptor.DescriptorSetLayoutBindings)
+		// Expects g_LayoutsMutex to be held
+		static VkDescriptorSetLayout RequestDescriptorSetLayout(VkDevice device, std::vector<VkDescriptorSetLayoutBinding> bindings)
+		{
+			// Binding order doesn't matter to Vulkan, so it doesn't get to split the cache either
+			std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
+
+			auto key = GetDescriptorSetLayoutKey(bindings);
+			auto layoutSearch = g_DescriptorSetLayouts.find(key);
+			if (layoutSearch != g_DescriptorSetLayouts.end())
+				return layoutSearch->second;
+
+			VkDescriptorSetLayoutCreateInfo layoutInfo
 			{
-				VkDescriptorSetLayoutCreateInfo layoutInfo
-				{
-					.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-					.bindingCount = static_cast<uint32_t>(descriptorBinding.size()),
-					.pBindings = descriptorBinding.data(),
-				};
-			
-				descriptorSetLayouts.emplace_back();
-				if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayouts.back()) != VK_SUCCESS)
-					PXL8_CORE_ERROR("Failed to create descriptor set layout!");
+				.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+				.bindingCount = static_cast<uint32_t>(bindings.size()),
+				.pBindings = bindings.data(),
+			};
+
+			VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+			if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+			{
+				PXL8_CORE_ERROR("Failed to create descriptor set layout!");
+				return VK_NULL_HANDLE;
 			}
+
+			g_DescriptorSetLayouts.emplace(key, descriptorSetLayout);
+
+			return descriptorSetLayout;
+		}
+
+		static std::vector<VkDescriptorSetLayout> RequestDescriptorSetLayouts(VkDevice device, const std::vector<std::vector<VkDescriptorSetLayoutBinding>>& descriptorSetLayoutBindings)
+		{
+			std::lock_guard<std::mutex> lock(g_LayoutsMutex);
+
+			std::vector<VkDescriptorSetLayout> descriptorSetLayouts{};
+			descriptorSetLayouts.reserve(descriptorSetLayoutBindings.size());
+
+			for (auto& descriptorBinding : descriptorSetLayoutBindings)
+				descriptorSetLayouts.push_back(RequestDescriptorSetLayout(device, descriptorBinding));
 			
 			return descriptorSetLayouts;
 		}
 
-		VkPipelineLayout GetPipelineLayout(VkDevice device, const GraphicsPipelineDescriptor& descriptor)
+		static VkPipelineLayout RequestPipelineLayout(
+			VkDevice device,
+			const std::vector<std::vector<VkDescriptorSetLayoutBinding>>& descriptorSetLayoutBindings,
+			std::vector<VkPushConstantRange> pushConstantRanges)
 		{
-			auto descriptorSetLayouts = GetDescriptorSetLayouts(device, descriptor);
+			auto descriptorSetLayouts = RequestDescriptorSetLayouts(device, descriptorSetLayoutBindings);
+
+			std::sort(pushConstantRanges.begin(), pushConstantRanges.end(), [](const auto& a, const auto& b)
+				{
+					return a.offset != b.offset ? a.offset < b.offset : a.stageFlags < b.stageFlags;
+				});
+
+			// The set layouts are deduplicated already, so their handles identify them
+			Hasher hasher;
+			hasher.Hash((uint64_t)descriptorSetLayouts.size());
+			for (auto descriptorSetLayout : descriptorSetLayouts)
+				hasher.Hash(reinterpret_cast<uint64_t>(descriptorSetLayout));
+
+			hasher.Hash((uint64_t)pushConstantRanges.size());
+			for (const auto& range : pushConstantRanges)
+			{
+				hasher.Hash((uint32_t)range.stageFlags);
+				hasher.Hash(range.offset);
+				hasher.Hash(range.size);
+			}
+			auto key = hasher.GetValue();
+
+			std::lock_guard<std::mutex> lock(g_LayoutsMutex);
+			g_LayoutRequestCount++;
+
+			auto layoutSearch = g_PipelineLayouts.find(key);
+			if (layoutSearch != g_PipelineLayouts.end())
+				return layoutSearch->second;
 
 			VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo
 			{
@@ -40,20 +125,68 @@ namespace Pixelate
 				.flags = 0,
 				.setLayoutCount = (uint32_t)descriptorSetLayouts.size(),
 				.pSetLayouts = descriptorSetLayouts.data(),
-				.pushConstantRangeCount = (uint32_t)descriptor.PushConstantRanges.size(),
-				.pPushConstantRanges = descriptor.PushConstantRanges.data(),
+				.pushConstantRangeCount = (uint32_t)pushConstantRanges.size(),
+				.pPushConstantRanges = pushConstantRanges.data(),
 			};
 
-			VkPipelineLayout pipelineLayout{};
+			VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
 			auto result = vkCreatePipelineLayout(device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
 
 			if (result != VK_SUCCESS)
+			{
 				PXL8_CORE_ERROR("Failed to create pipeline layout!");
+				return VK_NULL_HANDLE;
+			}
+
+			g_PipelineLayouts.emplace(key, pipelineLayout);
 
 			return pipelineLayout;
 		}
 
-		static std::vector<VkPipelineShaderStageCreateInfo> GetPipelineShaderStageInfo(VkDevice device, const GraphicsPipelineDescriptor& descriptor)
+		bool UsesBindlessLayout(const GraphicsPipelineDescriptor& descriptor)
+		{
+			return BindlessDescriptors::IsEnabled() && descriptor.DescriptorSetLayoutBindings.empty() && descriptor.PushConstantRanges.empty();
+		}
+
+		bool UsesBindlessLayout(const ComputePipelineDescriptor& descriptor)
+		{
+			return BindlessDescriptors::IsEnabled() && descriptor.DescriptorSetLayoutBindings.empty() && descriptor.PushConstantRanges.empty();
+		}
+
+		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts(VkDevice device, const GraphicsPipelineDescriptor& descriptor)
+		{
+			if (UsesBindlessLayout(descriptor))
+				return { BindlessDescriptors::GetDescriptorSetLayout() };
+
+			return RequestDescriptorSetLayouts(device, descriptor.DescriptorSetLayoutBindings);
+		}
+
+		std::vector<VkDescriptorSetLayout> GetDescriptorSetLayouts(VkDevice device, const ComputePipelineDescriptor& descriptor)
+		{
+			if (UsesBindlessLayout(descriptor))
+				return { BindlessDescriptors::GetDescriptorSetLayout() };
+
+			return RequestDescriptorSetLayouts(device, descriptor.DescriptorSetLayoutBindings);
+		}
+
+		VkPipelineLayout GetPipelineLayout(VkDevice device, const GraphicsPipelineDescriptor& descriptor)
+		{
+			if (UsesBindlessLayout(descriptor))
+				return BindlessDescriptors::GetPipelineLayout();
+
+			return RequestPipelineLayout(device, descriptor.DescriptorSetLayoutBindings, descriptor.PushConstantRanges);
+		}
+
+		VkPipelineLayout GetPipelineLayout(VkDevice device, const ComputePipelineDescriptor& descriptor)
+		{
+			if (UsesBindlessLayout(descriptor))
+				return BindlessDescriptors::GetPipelineLayout();
+
+			return RequestPipelineLayout(device, descriptor.DescriptorSetLayoutBindings, descriptor.PushConstantRanges);
+		}
+
+		// The stages point into stageCode, which has to be released once the pipeline is created
+		static std::vector<VkPipelineShaderStageCreateInfo> GetPipelineShaderStageInfo(const GraphicsPipelineDescriptor& descriptor, std::vector<ShaderStageCode>& stageCode)
 		{
 			constexpr std::array<VkShaderStageFlagBits, 2> supportedGraphicsShaderStages
 			{
@@ -71,46 +204,22 @@ namespace Pixelate
 					continue;
 				}
 
-				std::string shaderPath = descriptor.ShaderDescriptor.Path;
-
-				if (shaderPath.back() != '/')
-					shaderPath += '/';
-
-				shaderPath += descriptor.ShaderDescriptor.Name;
-				switch (shaderStage)
-				{
-				case VK_SHADER_STAGE_VERTEX_BIT:
-					shaderPath += "_vertex.spv";
-					break;
-				case VK_SHADER_STAGE_FRAGMENT_BIT:
-					shaderPath += "_fragment.spv";
-					break;
-				}
-
-				std::vector<char> spirvByteCode = Helpers::ReadFile(shaderPath);
-
-				VkShaderModuleCreateInfo createInfo
-				{
-					.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-					.codeSize = spirvByteCode.size(),
-					.pCode = reinterpret_cast<const uint32_t*>(spirvByteCode.data()),
-				};
-
-				VkShaderModule shaderModule;
-				auto result = vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule);
-
-				if (result != VK_SUCCESS)
-					PXL8_CORE_ERROR("Failed to create shader module from spirv byte data!");
+				stageCode.push_back(ShaderModules::Acquire(descriptor.ShaderDescriptor.GetStagePath(shaderStage)));
 
 				shaderStages.emplace_back(VkPipelineShaderStageCreateInfo
 				{
 					.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
 					.stage = shaderStage,
-					.module = shaderModule,
+					.module = stageCode.back().Module,
 					.pName = "main",
 				});
 			}
 
+			// Only now that stageCode won't reallocate anymore
+			for (size_t i = 0; i < shaderStages.size(); i++)
+				if (stageCode[i].Module == VK_NULL_HANDLE)
+					shaderStages[i].pNext = &stageCode[i].CreateInfo;
+
 			return shaderStages;
 		}
 
@@ -177,11 +286,10 @@ namespace Pixelate
 		static VkPipeline CreateGraphicsPipeline(
 			VkDevice device,
 			const PixelatePass& pass,
-			VkViewport& viewport,
-			VkRect2D& scissor,
 			VkFormat swapchainFormat)
 		{
-			auto shaderStages = GetPipelineShaderStageInfo(device, pass.GraphicsPipelineDescriptor);
+			std::vector<ShaderStageCode> stageCode{};
+			auto shaderStages = GetPipelineShaderStageInfo(pass.GraphicsPipelineDescriptor, stageCode);
 			auto pipelineLayout = GetPipelineLayout(device, pass.GraphicsPipelineDescriptor);
 			
 			VkPipelineVertexInputStateCreateInfo vertexInputInfo =
@@ -193,13 +301,19 @@ namespace Pixelate
 				.pVertexAttributeDescriptions = pass.GraphicsPipelineDescriptor.VertexInputAttributes.data(),
 			};
 			
+			// The viewport and scissor themselves are dynamic
 			VkPipelineViewportStateCreateInfo viewportState =
 			{
 				.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
 				.viewportCount = 1,
-				.pViewports = &viewport,
 				.scissorCount = 1,
-				.pScissors = &scissor,
+			};
+
+			VkPipelineDynamicStateCreateInfo dynamicState =
+			{
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+				.dynamicStateCount = (uint32_t)DYNAMIC_STATES.size(),
+				.pDynamicStates = DYNAMIC_STATES.data(),
 			};
 			
 			auto [colorBlendState, colorBlendAttachmentState] = GetColorBlendState(pass.GraphicsPipelineDescriptor, pass.Outputs);
@@ -219,38 +333,275 @@ namespace Pixelate
 				.pMultisampleState = &pass.GraphicsPipelineDescriptor.MultisamplingState,
 				.pDepthStencilState = &pass.GraphicsPipelineDescriptor.DepthStencilState,
 				.pColorBlendState = &colorBlendState,
+				.pDynamicState = &dynamicState,
 				.layout = pipelineLayout,
 			};
 			
-			VkPipeline pipeline;
-			auto result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			auto result = vkCreateGraphicsPipelines(device, PipelineCache::GetVkPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+
+			for (const auto& code : stageCode)
+				ShaderModules::Release(code);
 			
 			if (result != VK_SUCCESS)
+			{
 				PXL8_CORE_ERROR(std::string("Failed to create pipeline with shader: ") + pass.GraphicsPipelineDescriptor.ShaderDescriptor.Name);
+				return VK_NULL_HANDLE;
+			}
 
 			PXL8_CORE_INFO(std::string("Pipeline created successfully for shader: ") + pass.GraphicsPipelineDescriptor.ShaderDescriptor.Name);
 
 			return pipeline;
 		}
 
-		std::unordered_map<uint64_t, VkPipeline> g_Pipelines{};
+		static VkPipeline CreateComputePipeline(VkDevice device, const PixelatePass& pass)
+		{
+			const auto& descriptor = pass.ComputePipelineDescriptor;
+			auto stageCode = ShaderModules::Acquire(descriptor.ShaderDescriptor.GetStagePath(VK_SHADER_STAGE_COMPUTE_BIT));
 
-		VkPipeline GetGraphicsPipeline(
-			VkDevice device,
+			VkComputePipelineCreateInfo pipelineInfo =
+			{
+				.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+				.stage =
+				{
+					.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+					.pNext = stageCode.Module == VK_NULL_HANDLE ? &stageCode.CreateInfo : nullptr,
+					.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+					.module = stageCode.Module,
+					.pName = "main",
+				},
+				.layout = GetPipelineLayout(device, descriptor),
+			};
+
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			auto result = vkCreateComputePipelines(device, PipelineCache::GetVkPipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+
+			ShaderModules::Release(stageCode);
+
+			if (result != VK_SUCCESS)
+			{
+				PXL8_CORE_ERROR(std::string("Failed to create compute pipeline with shader: ") + descriptor.ShaderDescriptor.Name);
+				return VK_NULL_HANDLE;
+			}
+
+			PXL8_CORE_INFO(std::string("Compute pipeline created successfully for shader: ") + descriptor.ShaderDescriptor.Name);
+
+			return pipeline;
+		}
+
+		// Everything CreateGraphicsPipeline bakes into the pipeline, so equal keys mean interchangeable pipelines.
+		// DYNAMIC_STATES, the viewport and scissor included, are not part of it.
+		static uint64_t GetPipelineKey(
 			const PixelatePass& pass,
-			VkViewport viewport,
-			VkRect2D scissor,
 			VkFormat swapchainFormat)
 		{
-			auto hash = pass.GraphicsPipelineDescriptor.Hash();
+			Hasher hasher;
+			hasher.Hash(pass.GraphicsPipelineDescriptor.Hash());
+
+			auto renderingInfo = GetPipelineRenderingInfo(pass, swapchainFormat);
+			hasher.Hash((uint64_t)renderingInfo.ColorAttachmentFormats.size());
+			for (auto format : renderingInfo.ColorAttachmentFormats)
+				hasher.Hash((uint32_t)format);
+			hasher.Hash((uint32_t)renderingInfo.PipelineRenderingCreateInfo.depthAttachmentFormat);
+
+			// Same order as GetColorBlendState
+			for (const auto& output : pass.Outputs)
+			{
+				if (!(output.UsageFlags & PixelateResourceUsageFlags::PIXELATE_USAGE_COLOR_ATTACMENT))
+					continue;
+
+				const auto& blendState = output.BlendState;
+				hasher.Hash(blendState.blendEnable);
+				if (blendState.blendEnable)
+				{
+					hasher.Hash((uint32_t)blendState.srcColorBlendFactor);
+					hasher.Hash((uint32_t)blendState.dstColorBlendFactor);
+					hasher.Hash((uint32_t)blendState.colorBlendOp);
+					hasher.Hash((uint32_t)blendState.srcAlphaBlendFactor);
+					hasher.Hash((uint32_t)blendState.dstAlphaBlendFactor);
+					hasher.Hash((uint32_t)blendState.alphaBlendOp);
+				}
+				hasher.Hash((uint32_t)blendState.colorWriteMask);
+			}
+
+			return hasher.GetValue();
+		}
+
+		std::unordered_map<uint64_t, PipelineHandle> g_Pipelines{};
+		std::mutex g_PipelinesMutex;
+		uint32_t g_PipelineRequestCount = 0; // guarded by g_PipelinesMutex
+		std::unique_ptr<WorkerPool> g_PipelineCompilePool;
+
+		static WorkerPool& GetPipelineCompilePool()
+		{
+			if (!g_PipelineCompilePool)
+				g_PipelineCompilePool = std::make_unique<WorkerPool>("PipelineCompile", WorkerPool::GetDefaultThreadCount());
+
+			return *g_PipelineCompilePool;
+		}
+
+		// Identical requests share one compile job, even while it is still in flight, across passes and graphs
+		static PipelineHandle RequestPipeline(uint64_t hash, const PixelatePass& pass, std::function<VkPipeline()> createPipeline)
+		{
+			std::lock_guard<std::mutex> lock(g_PipelinesMutex);
+			g_PipelineRequestCount++;
 
 			auto pipelineSearch = g_Pipelines.find(hash);
 			if (pipelineSearch != g_Pipelines.end())
+			{
+				PXL8_CORE_TRACE(std::string("Pass ") + pass.Name + " reuses an identical pipeline.");
 				return pipelineSearch->second;
+			}
 
-			g_Pipelines.emplace(hash, CreateGraphicsPipeline(device, pass, viewport, scissor, swapchainFormat));
-			
-			return g_Pipelines.at(hash);
+			auto state = std::make_shared<PipelineCompileState>();
+			auto promise = std::make_shared<std::promise<VkPipeline>>();
+			state->Compiled = promise->get_future().share();
+
+			// Compile times show up in the CPU profiler's trace
+			GetPipelineCompilePool().Submit([createPipeline = std::move(createPipeline), state, promise]()
+				{
+					PXL8_PROFILE_SCOPE("Pipelines::CompilePipeline");
+
+					auto pipeline = createPipeline();
+
+					state->Pipeline.store(pipeline, std::memory_order_release);
+					promise->set_value(pipeline);
+				});
+
+			return g_Pipelines.emplace(hash, PipelineHandle(state)).first->second;
+		}
+
+		PipelineHandle RequestGraphicsPipeline(
+			VkDevice device,
+			const PixelatePass& pass,
+			VkFormat swapchainFormat)
+		{
+			return RequestPipeline(GetPipelineKey(pass, swapchainFormat), pass, [device, pass, swapchainFormat]()
+				{
+					return CreateGraphicsPipeline(device, pass, swapchainFormat);
+				});
+		}
+
+		VkPipeline GetGraphicsPipeline(
+			VkDevice device,
+			const PixelatePass& pass,
+			VkFormat swapchainFormat)
+		{
+			PXL8_PROFILE_SCOPE("Pipelines::GetGraphicsPipeline");
+			return RequestGraphicsPipeline(device, pass, swapchainFormat).Wait();
+		}
+
+		PipelineHandle RequestComputePipeline(VkDevice device, const PixelatePass& pass)
+		{
+			// Tagged, so a compute key can never collide with a graphics key of the same descriptor hash
+			Hasher hasher;
+			hasher.Hash((uint32_t)PassType::Compute);
+			hasher.Hash(pass.ComputePipelineDescriptor.Hash());
+
+			return RequestPipeline(hasher.GetValue(), pass, [device, pass]()
+				{
+					return CreateComputePipeline(device, pass);
+				});
+		}
+
+		VkPipeline GetComputePipeline(VkDevice device, const PixelatePass& pass)
+		{
+			PXL8_PROFILE_SCOPE("Pipelines::GetComputePipeline");
+			return RequestComputePipeline(device, pass).Wait();
+		}
+
+		PixelateDynamicState GetDynamicState(const GraphicsPipelineDescriptor& descriptor)
+		{
+			PixelateDynamicState dynamicState
+			{
+				.InputAssembly = descriptor.InputAssemby,
+				.RasterizationState = descriptor.RasterizationState,
+				.DepthStencilState = descriptor.DepthStencilState,
+			};
+
+			// Chains aren't followed at record time
+			dynamicState.InputAssembly.pNext = nullptr;
+			dynamicState.RasterizationState.pNext = nullptr;
+			dynamicState.DepthStencilState.pNext = nullptr;
+			std::copy(std::begin(descriptor.ColorBlendingState.blendConstants), std::end(descriptor.ColorBlendingState.blendConstants), dynamicState.BlendConstants);
+
+			return dynamicState;
+		}
+
+		void SetDynamicState(VkCommandBuffer commandBuffer, const PixelateDynamicState& dynamicState, VkRect2D renderArea)
+		{
+			VkViewport viewport
+			{
+				.x = (float)renderArea.offset.x,
+				.y = (float)renderArea.offset.y,
+				.width = (float)renderArea.extent.width,
+				.height = (float)renderArea.extent.height,
+				.minDepth = 0.0f,
+				.maxDepth = 1.0f,
+			};
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &renderArea);
+
+			const auto& inputAssembly = dynamicState.InputAssembly;
+			vkCmdSetPrimitiveRestartEnable(commandBuffer, inputAssembly.primitiveRestartEnable);
+
+			const auto& rasterization = dynamicState.RasterizationState;
+			vkCmdSetRasterizerDiscardEnable(commandBuffer, rasterization.rasterizerDiscardEnable);
+			vkCmdSetCullMode(commandBuffer, rasterization.cullMode);
+			vkCmdSetFrontFace(commandBuffer, rasterization.frontFace);
+			vkCmdSetLineWidth(commandBuffer, rasterization.lineWidth);
+			vkCmdSetDepthBiasEnable(commandBuffer, rasterization.depthBiasEnable);
+			vkCmdSetDepthBias(commandBuffer, rasterization.depthBiasConstantFactor, rasterization.depthBiasClamp, rasterization.depthBiasSlopeFactor);
+
+			const auto& depthStencil = dynamicState.DepthStencilState;
+			vkCmdSetDepthTestEnable(commandBuffer, depthStencil.depthTestEnable);
+			vkCmdSetDepthWriteEnable(commandBuffer, depthStencil.depthWriteEnable);
+			vkCmdSetDepthCompareOp(commandBuffer, depthStencil.depthCompareOp);
+			vkCmdSetDepthBoundsTestEnable(commandBuffer, depthStencil.depthBoundsTestEnable);
+			vkCmdSetDepthBounds(commandBuffer, depthStencil.minDepthBounds, depthStencil.maxDepthBounds);
+			vkCmdSetStencilTestEnable(commandBuffer, depthStencil.stencilTestEnable);
+
+			for (auto [faceMask, stencil] : { std::pair{ VK_STENCIL_FACE_FRONT_BIT, depthStencil.front }, std::pair{ VK_STENCIL_FACE_BACK_BIT, depthStencil.back } })
+			{
+				vkCmdSetStencilOp(commandBuffer, faceMask, stencil.failOp, stencil.passOp, stencil.depthFailOp, stencil.compareOp);
+				vkCmdSetStencilCompareMask(commandBuffer, faceMask, stencil.compareMask);
+				vkCmdSetStencilWriteMask(commandBuffer, faceMask, stencil.writeMask);
+				vkCmdSetStencilReference(commandBuffer, faceMask, stencil.reference);
+			}
+
+			vkCmdSetBlendConstants(commandBuffer, dynamicState.BlendConstants);
+		}
+
+		void Dispose(VkDevice device)
+		{
+			if (g_PipelineCompilePool)
+				g_PipelineCompilePool->Dispose(); // in-flight compiles must finish before their pipelines are destroyed
+
+			g_PipelineCompilePool.reset();
+
+			if (g_PipelineRequestCount > 0)
+				PXL8_CORE_INFO(std::to_string(g_PipelineRequestCount) + " pipeline requests were served by " + std::to_string(g_Pipelines.size()) + " pipelines.");
+			g_PipelineRequestCount = 0;
+
+			for (auto& [hash, pipeline] : g_Pipelines)
+				vkDestroyPipeline(device, pipeline.Wait(), nullptr);
+
+			g_Pipelines.clear();
+
+			if (g_LayoutRequestCount > 0)
+				PXL8_CORE_INFO(std::to_string(g_LayoutRequestCount) + " pipeline layout requests were served by " + std::to_string(g_PipelineLayouts.size())
+					+ " pipeline layouts and " + std::to_string(g_DescriptorSetLayouts.size()) + " descriptor set layouts.");
+			g_LayoutRequestCount = 0;
+
+			// The pipelines using them are gone
+			for (auto& [hash, pipelineLayout] : g_PipelineLayouts)
+				vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+
+			for (auto& [hash, descriptorSetLayout] : g_DescriptorSetLayouts)
+				vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+
+			g_PipelineLayouts.clear();
+			g_DescriptorSetLayouts.clear();
 		}
 	}
-}
\ No newline at end of file
+}
@@ -3,6 +3,17 @@
 #include <filesystem>
 #include <iostream>
 
+#ifdef WIN64
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace Pixelate::Helpers
 {
 	std::vector<char> ReadFile(const std::string& filepath)
@@ -25,4 +36,141 @@ namespace Pixelate::Helpers
 		file.close();
 		return buffer;
 	}
-}
\ No newline at end of file
+
+	bool FileExists(const std::string& filepath)
+	{
+		std::error_code errorCode;
+		return std::filesystem::is_regular_file(filepath, errorCode);
+	}
+
+	bool WriteFileAtomic(const std::string& filepath, const void* data, size_t size)
+	{
+		auto temporaryFilepath = filepath + ".tmp";
+
+		{
+			std::ofstream file(temporaryFilepath, std::ios::binary | std::ios::trunc);
+
+			if (!file.is_open())
+			{
+				PXL8_CORE_ERROR(std::string("Failed to open file for writing at: ") + temporaryFilepath);
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(data), size);
+
+			if (!file.good())
+			{
+				PXL8_CORE_ERROR(std::string("Failed to write file at: ") + temporaryFilepath);
+				return false;
+			}
+		}
+
+		// rename replaces the destination in one step, a crash mid-write never leaves a truncated file behind
+		std::error_code errorCode;
+		std::filesystem::rename(temporaryFilepath, filepath, errorCode);
+
+		if (errorCode)
+		{
+			PXL8_CORE_ERROR(std::string("Failed to move file into place at: ") + filepath + " (" + errorCode.message() + ")");
+			std::filesystem::remove(temporaryFilepath, errorCode);
+			return false;
+		}
+
+		return true;
+	}
+
+	MappedFile::MappedFile(const std::string& filepath)
+	{
+#ifdef WIN64
+		auto file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			PXL8_CORE_ERROR(std::string("Failed to open file at: ") + filepath);
+			return;
+		}
+
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx(file, &fileSize);
+
+		// The mapping keeps the file alive, its handle isn't needed anymore
+		if (fileSize.QuadPart > 0)
+			m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+
+		if (m_Mapping == nullptr)
+		{
+			PXL8_CORE_ERROR(std::string("Failed to map file at: ") + filepath);
+			return;
+		}
+
+		m_Data = static_cast<const char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		auto file = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file < 0)
+		{
+			PXL8_CORE_ERROR(std::string("Failed to open file at: ") + filepath);
+			return;
+		}
+
+		struct stat fileStatus{};
+		if (fstat(file, &fileStatus) == 0 && fileStatus.st_size > 0)
+		{
+			auto data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (data != MAP_FAILED)
+			{
+				m_Data = static_cast<const char*>(data);
+				m_Size = static_cast<size_t>(fileStatus.st_size);
+			}
+		}
+		close(file); // the mapping keeps the file alive
+#endif
+
+		if (m_Data == nullptr)
+		{
+			PXL8_CORE_ERROR(std::string("Failed to map file at: ") + filepath);
+			Unmap();
+		}
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		Unmap();
+		std::swap(m_Data, other.m_Data);
+		std::swap(m_Size, other.m_Size);
+#ifdef WIN64
+		std::swap(m_Mapping, other.m_Mapping);
+#endif
+
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Unmap();
+	}
+
+	void MappedFile::Unmap()
+	{
+#ifdef WIN64
+		if (m_Data != nullptr)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping != nullptr)
+			CloseHandle(m_Mapping);
+		m_Mapping = nullptr;
+#else
+		if (m_Data != nullptr)
+			munmap(const_cast<char*>(m_Data), m_Size);
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+}
@@ -1,23 +1,142 @@
+#include <array>
+#include <bit>
 #include "pixelate_render_pass.h"
 #include "hasher.h"
+#include "shader_module_cache.h"
 
 namespace Pixelate
 {
+	constexpr std::array<VkShaderStageFlagBits, 2> g_SupportedGraphicsShaderStages
+	{
+		VkShaderStageFlagBits::VK_SHADER_STAGE_VERTEX_BIT,
+		VkShaderStageFlagBits::VK_SHADER_STAGE_FRAGMENT_BIT,
+	};
+
+	static void HashFloat(Hasher& hasher, float value)
+	{
+		// -0.0 and 0.0 configure the same state
+		hasher.Hash(value == 0.0f ? 0u : std::bit_cast<uint32_t>(value));
+	}
+
+	// Counts are hashed too, so elements can't shift between neighbouring lists
+	static void HashPipelineLayout(
+		Hasher& hasher,
+		const std::vector<std::vector<VkDescriptorSetLayoutBinding>>& descriptorSetLayoutBindings,
+		const std::vector<VkPushConstantRange>& pushConstantRanges)
+	{
+		hasher.Hash((uint64_t)descriptorSetLayoutBindings.size());
+		for (const auto& setBindings : descriptorSetLayoutBindings)
+		{
+			hasher.Hash((uint64_t)setBindings.size());
+			for (const auto& binding : setBindings)
+			{
+				hasher.Hash(binding.binding);
+				hasher.Hash((uint32_t)binding.descriptorType);
+				hasher.Hash(binding.descriptorCount);
+				hasher.Hash((uint32_t)binding.stageFlags);
+
+				if (binding.pImmutableSamplers != nullptr)
+					for (uint32_t i = 0; i < binding.descriptorCount; i++)
+						hasher.Hash(reinterpret_cast<uint64_t>(binding.pImmutableSamplers[i]));
+			}
+		}
+
+		hasher.Hash((uint64_t)pushConstantRanges.size());
+		for (const auto& range : pushConstantRanges)
+		{
+			hasher.Hash((uint32_t)range.stageFlags);
+			hasher.Hash(range.offset);
+			hasher.Hash(range.size);
+		}
+	}
+
+	std::string PixelateShaderDescriptor::GetStagePath(VkShaderStageFlagBits stage) const
+	{
+		std::string shaderPath = Path;
+
+		if (shaderPath.back() != '/')
+			shaderPath += '/';
+
+		shaderPath += Name;
+		switch (stage)
+		{
+		case VK_SHADER_STAGE_VERTEX_BIT:
+			shaderPath += "_vertex.spv";
+			break;
+		case VK_SHADER_STAGE_FRAGMENT_BIT:
+			shaderPath += "_fragment.spv";
+			break;
+		case VK_SHADER_STAGE_COMPUTE_BIT:
+			shaderPath += "_compute.spv";
+			break;
+		}
+
+		return shaderPath;
+	}
+
 	uint64_t GraphicsPipelineDescriptor::Hash() const
 	{
 		Hasher hasher;
 
-		hasher.Hash((const char*)DescriptorSetLayoutBindings.data(), sizeof(VkDescriptorSetLayoutBinding) * DescriptorSetLayoutBindings.size());
-		hasher.Hash((const char*)PushConstantRanges.data(), sizeof(PushConstantRanges) * PushConstantRanges.size());
-		hasher.Hash((const char*)VertexInputBindings.data(), sizeof(VkVertexInputBindingDescription) * VertexInputBindings.size());
-		hasher.Hash((const char*)VertexInputAttributes.data(), sizeof(VkVertexInputAttributeDescription) * VertexInputAttributes.size());
+		// Shaders by content, two names for the same SPIR-V share a pipeline
+		for (const auto& shaderStage : g_SupportedGraphicsShaderStages)
+		{
+			if (!(ShaderDescriptor.ShaderStages & shaderStage))
+				continue;
+
+			hasher.Hash((uint32_t)shaderStage);
+			hasher.Hash(ShaderModules::GetContentHash(ShaderDescriptor.GetStagePath(shaderStage)));
+		}
+
+		HashPipelineLayout(hasher, DescriptorSetLayoutBindings, PushConstantRanges);
+
+		hasher.Hash((uint64_t)VertexInputBindings.size());
+		for (const auto& binding : VertexInputBindings)
+		{
+			hasher.Hash(binding.binding);
+			hasher.Hash(binding.stride);
+			hasher.Hash((uint32_t)binding.inputRate);
+		}
+
+		hasher.Hash((uint64_t)VertexInputAttributes.size());
+		for (const auto& attribute : VertexInputAttributes)
+		{
+			hasher.Hash(attribute.location);
+			hasher.Hash(attribute.binding);
+			hasher.Hash((uint32_t)attribute.format);
+			hasher.Hash(attribute.offset);
+		}
+
+		// State in Pipelines::DYNAMIC_STATES is set while recording, so it doesn't tell pipelines apart
+		hasher.Hash((uint32_t)InputAssemby.topology);
+
+		hasher.Hash(RasterizationState.depthClampEnable);
+		hasher.Hash((uint32_t)RasterizationState.polygonMode);
+
+		hasher.Hash((uint32_t)MultisamplingState.rasterizationSamples);
+		hasher.Hash(MultisamplingState.sampleShadingEnable);
+		if (MultisamplingState.sampleShadingEnable)
+			HashFloat(hasher, MultisamplingState.minSampleShading);
+		hasher.Hash(MultisamplingState.pSampleMask != nullptr ? *MultisamplingState.pSampleMask : std::numeric_limits<uint32_t>::max());
+		hasher.Hash(MultisamplingState.alphaToCoverageEnable);
+		hasher.Hash(MultisamplingState.alphaToOneEnable);
+
+		// attachmentCount and pAttachments are filled in from the pass outputs, see Pipelines::GetPipelineKey
+		hasher.Hash(ColorBlendingState.logicOpEnable);
+		if (ColorBlendingState.logicOpEnable)
+			hasher.Hash((uint32_t)ColorBlendingState.logicOp);
+
+		return hasher.GetValue();
+	}
+
+	uint64_t ComputePipelineDescriptor::Hash() const
+	{
+		Hasher hasher;
+
+		hasher.Hash((uint32_t)VK_SHADER_STAGE_COMPUTE_BIT);
+		hasher.Hash(ShaderModules::GetContentHash(ShaderDescriptor.GetStagePath(VK_SHADER_STAGE_COMPUTE_BIT)));
 
-		hasher.Hash((const char*)&ShaderDescriptor, sizeof(PixelateShaderDescriptor));
-		hasher.Hash((const char*)&InputAssemby, sizeof(VkPipelineInputAssemblyStateCreateInfo));
-		hasher.Hash((const char*)&RasterizationState, sizeof(VkPipelineRasterizationStateCreateInfo));
-		hasher.Hash((const char*)&MultisamplingState, sizeof(VkPipelineMultisampleStateCreateInfo));
-		hasher.Hash((const char*)&DepthStencilState, sizeof(VkPipelineDepthStencilStateCreateInfo));
-		hasher.Hash((const char*)&ColorBlendingState, sizeof(VkPipelineColorBlendStateCreateInfo));
+		HashPipelineLayout(hasher, DescriptorSetLayoutBindings, PushConstantRanges);
 
 		return hasher.GetValue();
 	}
@@ -38,7 +157,9 @@ namespace Pixelate
 		Name(other.Name),
 		Flags(other.Flags),
 		Inputs(std::vector<PixelateResourceUsage>(other.Inputs)),
-		Outputs(std::vector<PixelateResourceUsage>(other.Outputs))
+		Outputs(std::vector<PixelateResourceUsage>(other.Outputs)),
+		CommandBufferGraphicsSlice(other.CommandBufferGraphicsSlice),
+		SliceCount(other.SliceCount)
 	{
 		switch (other.PassType)
 		{
@@ -50,16 +171,28 @@ namespace Pixelate
 			new (&HostPipelineDescriptor) Pixelate::HostPipelineDescriptor(other.HostPipelineDescriptor);
 			CommandBufferHost = other.CommandBufferHost;
 			break;
+		case PassType::Compute:
+			new (&ComputePipelineDescriptor) Pixelate::ComputePipelineDescriptor(other.ComputePipelineDescriptor);
+			CommandBufferCompute = other.CommandBufferCompute;
+			break;
 		}
 	}
 
 	PixelatePass& PixelatePass::operator=(const PixelatePass& other)
 	{
+		if (this == &other)
+			return *this;
+
+		// The descriptor union holds the old pass type's member, it has to go before the new one is constructed over it
+		DestroyPipelineDescriptor();
+
 		PassType = other.PassType;
 		Name = other.Name;
 		Flags = other.Flags;
 		Inputs = std::vector<PixelateResourceUsage>(other.Inputs);
 		Outputs = std::vector<PixelateResourceUsage>(other.Outputs);
+		CommandBufferGraphicsSlice = other.CommandBufferGraphicsSlice;
+		SliceCount = other.SliceCount;
 
 		switch (other.PassType)
 		{
@@ -71,6 +204,10 @@ namespace Pixelate
 			new (&HostPipelineDescriptor) Pixelate::HostPipelineDescriptor(other.HostPipelineDescriptor);
 			CommandBufferHost = other.CommandBufferHost;
 			break;
+		case PassType::Compute:
+			new (&ComputePipelineDescriptor) Pixelate::ComputePipelineDescriptor(other.ComputePipelineDescriptor);
+			CommandBufferCompute = other.CommandBufferCompute;
+			break;
 		}
 
 		return *this;
@@ -81,7 +218,9 @@ namespace Pixelate
 		Name(other.Name),
 		Flags(other.Flags),
 		Inputs(std::move(other.Inputs)),
-		Outputs(std::move(other.Outputs))
+		Outputs(std::move(other.Outputs)),
+		CommandBufferGraphicsSlice(other.CommandBufferGraphicsSlice),
+		SliceCount(other.SliceCount)
 	{
 		switch (other.PassType)
 		{
@@ -93,16 +232,28 @@ namespace Pixelate
 			new (&HostPipelineDescriptor) Pixelate::HostPipelineDescriptor(std::move(other.HostPipelineDescriptor));
 			CommandBufferHost = other.CommandBufferHost;
 			break;
+		case PassType::Compute:
+			new (&ComputePipelineDescriptor) Pixelate::ComputePipelineDescriptor(std::move(other.ComputePipelineDescriptor));
+			CommandBufferCompute = other.CommandBufferCompute;
+			break;
 		}
 	}
 
 	PixelatePass& PixelatePass::operator=(PixelatePass&& other) noexcept
 	{
+		if (this == &other)
+			return *this;
+
+		// The descriptor union holds the old pass type's member, it has to go before the new one is constructed over it
+		DestroyPipelineDescriptor();
+
 		PassType = other.PassType;
 		Name = other.Name;
 		Flags = other.Flags;
 		Inputs = std::move(other.Inputs);
 		Outputs = std::move(other.Outputs);
+		CommandBufferGraphicsSlice = other.CommandBufferGraphicsSlice;
+		SliceCount = other.SliceCount;
 
 		switch (other.PassType)
 		{
@@ -114,6 +265,10 @@ namespace Pixelate
 			new (&HostPipelineDescriptor) Pixelate::HostPipelineDescriptor(std::move(other.HostPipelineDescriptor));
 			CommandBufferHost = other.CommandBufferHost;
 			break;
+		case PassType::Compute:
+			new (&ComputePipelineDescriptor) Pixelate::ComputePipelineDescriptor(std::move(other.ComputePipelineDescriptor));
+			CommandBufferCompute = other.CommandBufferCompute;
+			break;
 		}
 
 		return *this;
@@ -136,13 +291,43 @@ namespace Pixelate
 	{
 	}
 
-	PixelatePass::~PixelatePass()
+	PixelatePass::PixelatePass(
+		const char* name,
+		Pixelate::ComputePipelineDescriptor&& pipeline,
+		PixelatePassFlags flags,
+		CommandCompute commandBuffer,
+		std::vector<PixelateResourceUsage>&& inputs,
+		std::vector<PixelateResourceUsage>&& outputs) :
+		PassType(Pixelate::PassType::Compute),
+		Name(name),
+		ComputePipelineDescriptor(std::move(pipeline)),
+		Flags(flags),
+		CommandBufferCompute(commandBuffer),
+		Inputs(std::move(inputs)),
+		Outputs(std::move(outputs))
+	{
+	}
+
+	void PixelatePass::DestroyPipelineDescriptor()
 	{
 		switch (PassType)
 		{
 		case PassType::Graphics:
 			GraphicsPipelineDescriptor.~GraphicsPipelineDescriptor();
 			break;
+		case PassType::Host:
+			HostPipelineDescriptor.~HostPipelineDescriptor();
+			break;
+		case PassType::Compute:
+			ComputePipelineDescriptor.~ComputePipelineDescriptor();
+			break;
 		}
+
+		PassType = Pixelate::PassType::None;
+	}
+
+	PixelatePass::~PixelatePass()
+	{
+		DestroyPipelineDescriptor();
 	};
 }
\ No newline at end of file
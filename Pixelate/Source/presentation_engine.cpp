@@ -1,12 +1,11 @@
 #include "presentation_engine.h"
 #include "internal_pixelate_include.h"
 #include "log.h"
-#include "semaphore_manager.h"
-#include "queue_manager.h"
-#include "fence_manager.h"
-#include "command_buffer_manager.h"
 #include "window.h"
 #include "pixelate_settings.h"
+#include "queue_manager.h"
+#include "timeline_manager.h"
+#include "cpu_profiler.h"
 
 namespace Pixelate
 {
@@ -60,6 +59,15 @@ namespace Pixelate
 		}
 	}
 
+	// Compared to the size at the last recreation rather than the swapchain extent, the surface may clamp that
+	static VkExtent2D GetDrawableExtent(SDL_Window* window)
+	{
+		int width, height;
+		SDL_Vulkan_GetDrawableSize(window, &width, &height);
+
+		return VkExtent2D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+	}
+
 	static void ValidateSwapchainCreation(VkResult result)
 	{
 		switch (result)
@@ -88,12 +96,19 @@ namespace Pixelate
 		auto i = 0;
 		for (const auto& queueFamilyProperties : queueFamilies)
 		{
-			if (queueFamilyProperties.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+			if ((queueFamilyProperties.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !result.GraphicsQueueFamily.has_value())
 				result.GraphicsQueueFamily = i;
 
-			if (queueFamilyProperties.queueFlags & VK_QUEUE_COMPUTE_BIT)
+			// A family without graphics runs compute work asynchronously to the graphics queue
+			if ((queueFamilyProperties.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilyProperties.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !result.ComputeQueueFamily.has_value())
 				result.ComputeQueueFamily = i;
 
+			// Copy engines of discrete GPUs, only taken if they can copy single texels so image uploads need no special casing
+			auto transferGranularity = queueFamilyProperties.minImageTransferGranularity;
+			auto isTransferOnly = (queueFamilyProperties.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamilyProperties.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+			if (isTransferOnly && transferGranularity.width == 1 && transferGranularity.height == 1 && transferGranularity.depth == 1 && !result.TransferQueueFamily.has_value())
+				result.TransferQueueFamily = i;
+
 			if (surface != VK_NULL_HANDLE && !result.PresentQueueFamily.has_value())
 			{
 				VkBool32 presentSupport = false;
@@ -106,6 +121,13 @@ namespace Pixelate
 			i++;
 		}
 
+		// Graphics families always support compute, without a dedicated family compute shares the graphics queue
+		if (!result.ComputeQueueFamily.has_value())
+			result.ComputeQueueFamily = result.GraphicsQueueFamily;
+
+		if (!result.TransferQueueFamily.has_value())
+			result.TransferQueueFamily = result.GraphicsQueueFamily;
+
 		return result;
 	}
 
@@ -145,6 +167,10 @@ namespace Pixelate
 			if (strcmp(extension.extensionName, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
 				swapchainExtensionSupported = true;
 
+		// Headless, there is no surface to query, the extension is still needed for the present layout
+		if (surface == VK_NULL_HANDLE)
+			return swapchainExtensionSupported;
+
 		bool swapchainAdequate = false;
 		if (swapchainExtensionSupported)
 		{
@@ -164,13 +190,36 @@ namespace Pixelate
 		m_Device(device),
 		m_Surface(surface)
 	{
-		Recreate();
+		Create();
+	}
+
+	PixelateSwapchain::PixelateSwapchain(PixelateDevice device, VmaAllocator allocator, VkExtent2D extent) :
+		SupportDetails(),
+		SurfaceFormat{ PixelateSettings::PREFERRED_SWAPCHAIN_IMAGE_FORMAT, PixelateSettings::PREFERRED_SWAPCHAIN_COLOR_SPACE },
+		PresentMode(VK_PRESENT_MODE_FIFO_KHR), // never presented, frames are paced by the frame pacer alone
+		Extent(extent),
+		VkSwapchain(VK_NULL_HANDLE),
+		m_Device(device),
+		m_Allocator(allocator)
+	{
+		Create();
 	}
 
 	void PixelateSwapchain::Dispose()
 	{
 		DisposeImageViews();
-		vkDestroySwapchainKHR(m_Device.VkDevice, VkSwapchain, nullptr);
+
+		if (!IsHeadless())
+		{
+			vkDestroySwapchainKHR(m_Device.VkDevice, VkSwapchain, nullptr);
+			return;
+		}
+
+		for (size_t i = 0; i < SwapchainImages.size(); i++)
+			vmaDestroyImage(m_Allocator, SwapchainImages[i], m_OffscreenAllocations[i]);
+
+		SwapchainImages.clear();
+		m_OffscreenAllocations.clear();
 	}
 
 	void PixelateSwapchain::DisposeImageViews()
@@ -181,11 +230,69 @@ namespace Pixelate
 		SwapchainImageViews.clear();
 	}
 
-	void PixelateSwapchain::Recreate()
+	bool PixelateSwapchain::Recreate(SDL_Window* window, VkExtent2D headlessExtent, RetiredSwapchain& retired)
 	{
-		DisposeImageViews();
+		PXL8_PROFILE_SCOPE("PixelateSwapchain::Recreate");
+
+		// The capabilities, and with them the extent, change with the window
+		auto supportDetails = IsHeadless() ? SupportDetails : QuerySwapChainSupport(m_Device.VkPhysicalDevice, m_Surface);
+		auto extent = IsHeadless() ? headlessExtent : ChooseSwapchainExtent(supportDetails.Capabilities, window);
+
+		if (extent.width == 0 || extent.height == 0)
+			return false;
+
+		if (!IsHeadless())
+		{
+			SupportDetails = std::move(supportDetails);
+			SurfaceFormat = ChooseSwapchainSurfaceFormat(SupportDetails.Formats);
+		}
+		Extent = extent;
+
+		retired.VkSwapchain = IsHeadless() ? VK_NULL_HANDLE : VkSwapchain;
+		retired.ImageViews = std::move(SwapchainImageViews);
+		SwapchainImageViews.clear();
+
+		if (IsHeadless())
+		{
+			retired.OffscreenImages = std::move(SwapchainImages);
+			retired.OffscreenAllocations = std::move(m_OffscreenAllocations);
+			SwapchainImages.clear();
+			m_OffscreenAllocations.clear();
+		}
+
+		Create();
+
+		return true;
+	}
 
-		uint32_t imageCount = std::clamp((uint32_t)3, (uint32_t)SupportDetails.Capabilities.minImageCount, (uint32_t)SupportDetails.Capabilities.maxImageCount);
+	void PixelateSwapchain::DisposeRetired(RetiredSwapchain& retired) const
+	{
+		for (auto imageView : retired.ImageViews)
+			vkDestroyImageView(m_Device.VkDevice, imageView, nullptr);
+
+		for (size_t i = 0; i < retired.OffscreenImages.size(); i++)
+			vmaDestroyImage(m_Allocator, retired.OffscreenImages[i], retired.OffscreenAllocations[i]);
+
+		if (retired.VkSwapchain != VK_NULL_HANDLE)
+			vkDestroySwapchainKHR(m_Device.VkDevice, retired.VkSwapchain, nullptr);
+
+		retired = RetiredSwapchain{};
+	}
+
+	void PixelateSwapchain::Create()
+	{
+		if (IsHeadless())
+		{
+			if (SwapchainImages.empty())
+				CreateOffscreenImages();
+
+			CreateImageViews();
+			return;
+		}
+
+		// A maxImageCount of 0 means there is no upper limit
+		auto maxImageCount = SupportDetails.Capabilities.maxImageCount > 0 ? SupportDetails.Capabilities.maxImageCount : std::numeric_limits<uint32_t>::max();
+		uint32_t imageCount = std::clamp((uint32_t)3, (uint32_t)SupportDetails.Capabilities.minImageCount, maxImageCount);
 
 		VkSwapchainCreateInfoKHR swapchainCreateInfo{};
 		swapchainCreateInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -200,7 +307,7 @@ namespace Pixelate
 		swapchainCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 		swapchainCreateInfo.presentMode = PresentMode;
 		swapchainCreateInfo.clipped = VK_TRUE;
-		swapchainCreateInfo.oldSwapchain = VkSwapchain;
+		swapchainCreateInfo.oldSwapchain = VkSwapchain; // retired, the presentation engine can hand its resources over to the new one
 
 		QueueFamilyIndices indices = GetQueueFamilyIndices(m_Device.VkPhysicalDevice, m_Surface);
 		uint32_t queueFamilyIndices[] = { indices.GraphicsQueueFamily.value(), indices.PresentQueueFamily.value() };
@@ -226,8 +333,50 @@ namespace Pixelate
 		SwapchainImages.resize(actualImageCount);
 		vkGetSwapchainImagesKHR(m_Device.VkDevice, VkSwapchain, &actualImageCount, SwapchainImages.data());
 
+		CreateImageViews();
+	}
+
+	void PixelateSwapchain::CreateOffscreenImages()
+	{
+		// One more than the frames in flight, like a triple-buffered swapchain
+		auto imageCount = PixelateSettings::MAX_FRAMES_IN_FLIGHT + 1;
+
+		VkImageCreateInfo imageCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+			.imageType = VK_IMAGE_TYPE_2D,
+			.format = SurfaceFormat.format,
+			.extent = { Extent.width, Extent.height, 1 },
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.samples = VK_SAMPLE_COUNT_1_BIT,
+			.tiling = VK_IMAGE_TILING_OPTIMAL,
+			.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, // transfer source for readbacks
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+			.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		};
+
+		VmaAllocationCreateInfo allocationCreateInfo
+		{
+			.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+		};
+
+		SwapchainImages.resize(imageCount);
+		m_OffscreenAllocations.resize(imageCount);
+
+		for (uint32_t i = 0; i < imageCount; i++)
+		{
+			if (vmaCreateImage(m_Allocator, &imageCreateInfo, &allocationCreateInfo, &SwapchainImages[i], &m_OffscreenAllocations[i], nullptr) != VK_SUCCESS)
+				PXL8_CORE_ERROR("Failed to create offscreen image!");
+		}
+
+		PXL8_CORE_TRACE(std::to_string(imageCount) + " offscreen images created successfully.");
+	}
+
+	void PixelateSwapchain::CreateImageViews()
+	{
 		SwapchainImageViews.resize(SwapchainImages.size());
-		for (auto i = 0; i < actualImageCount; i++)
+		for (auto i = 0; i < SwapchainImages.size(); i++)
 		{
 			VkImageViewCreateInfo createInfo{};
 			createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -242,7 +391,7 @@ namespace Pixelate
 			createInfo.subresourceRange.levelCount = 1;
 			createInfo.subresourceRange.baseArrayLayer = 0;
 			createInfo.subresourceRange.layerCount = 1;
-			createInfo.image = SwapchainImages[0];
+			createInfo.image = SwapchainImages[i];
 
 			if (vkCreateImageView(m_Device.VkDevice, &createInfo, nullptr, &SwapchainImageViews[i]) != VK_SUCCESS)
 				PXL8_CORE_ERROR("Failed to create swapchain image views!");
@@ -252,23 +401,64 @@ namespace Pixelate
 	}
 
 	PixelatePresentationEngine::PixelatePresentationEngine(int width, int height, SDL_Window* window, VkSurfaceKHR surface)
-		: m_Width(width), m_Height(height), m_Window(window), m_VkSurfaceKHR(surface), m_Swapchain()
+		: m_Backend(PresentationBackend::Window), m_Width(width), m_Height(height), m_Window(window), m_VkSurfaceKHR(surface), m_Swapchain()
 	{}
 
-	void PixelatePresentationEngine::Initialize(PixelateDevice device)
+	PixelatePresentationEngine::PixelatePresentationEngine(int width, int height)
+		: m_Backend(PresentationBackend::Headless), m_Width(width), m_Height(height), m_Window(nullptr), m_VkSurfaceKHR(VK_NULL_HANDLE), m_Swapchain()
+	{}
+
+	void PixelatePresentationEngine::Initialize(PixelateDevice device, VmaAllocator allocator)
 	{
 		m_Device = device;
 
+		if (IsHeadless())
+		{
+			// Acquire and present become empty submissions on the graphics queue that keep the binary semaphores balanced
+			vkGetDeviceQueue(m_Device.VkDevice, m_Device.QueueFamilyIndices.GraphicsQueueFamily.value(), 0, &m_PresentQueue);
+			m_Swapchain = PixelateSwapchain(device, allocator, VkExtent2D{ static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height) });
+			return;
+		}
+
 		vkGetDeviceQueue(m_Device.VkDevice, m_Device.QueueFamilyIndices.PresentQueueFamily.value(), 0, &m_PresentQueue);;
 
 		m_Swapchain = PixelateSwapchain(device, m_VkSurfaceKHR, m_Window);
-
-		m_ImageTransitionCommandBuffers.resize(m_Swapchain.SwapchainImages.size());
+		m_DrawableExtent = GetDrawableExtent(m_Window);
 	}
 
 	uint32_t PixelatePresentationEngine::AcquireSwapcahinImage(VkSemaphore signalSemaphore, VkFence signalFence)
 	{
-		vkDeviceWaitIdle(m_Device.VkDevice);
+		PXL8_PROFILE_SCOPE("PixelatePresentationEngine::AcquireSwapchainImage");
+
+		// Simulates a surface that changed size, like OUT_OF_DATE from a real swapchain
+		if (IsHeadless() && m_SwapchainOutOfDate)
+			return INVALID_SWAPCHAIN_IMAGE_INDEX;
+
+		if (IsHeadless())
+		{
+			auto imageIndex = m_NextOffscreenImage;
+			m_NextOffscreenImage = (m_NextOffscreenImage + 1) % m_Swapchain.SwapchainImages.size();
+
+			// Signaled after all earlier work on the queue, which includes the last frame that rendered into the image
+			VkSemaphoreSubmitInfo signalSemaphoreInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+				.semaphore = signalSemaphore,
+				.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			};
+
+			VkSubmitInfo2 submitInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+				.signalSemaphoreInfoCount = signalSemaphore != VK_NULL_HANDLE ? 1u : 0u,
+				.pSignalSemaphoreInfos = &signalSemaphoreInfo,
+			};
+
+			if (signalSemaphore != VK_NULL_HANDLE || signalFence != VK_NULL_HANDLE)
+				QueueManager::GraphicsQueueSubmit(m_Device, GraphicsQueueSubmitDescriptor(), &submitInfo, 1, signalFence);
+
+			return imageIndex;
+		}
 
 		uint32_t imageIndex = std::numeric_limits<uint32_t>::max();
 		auto result = vkAcquireNextImageKHR(
@@ -279,126 +469,162 @@ namespace Pixelate
 			signalFence,
 			&imageIndex);
 
-		return imageIndex;
-	}
-
-	void ValidateSwapchainResult(VkResult result)
-	{
-		if (result == VK_SUBOPTIMAL_KHR)
-			PXL8_APP_WARN("Swapchain is suboptimal!");
-
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
-			PXL8_APP_WARN("Swapchain is out of date!");
-
-		if (result == VK_ERROR_DEVICE_LOST)
-			PXL8_APP_WARN("Device was lost during swapchain presentation!");
-
-		if (result != VK_SUCCESS)
-			PXL8_APP_WARN("Unknown error during present queue submission!");
+		switch (result)
+		{
+		case VK_SUCCESS:
+			return imageIndex;
+		case VK_SUBOPTIMAL_KHR:
+			// The image is acquired and the semaphore will be signaled, render this frame and recreate before the next
+			m_SwapchainOutOfDate = true;
+			return imageIndex;
+		case VK_ERROR_OUT_OF_DATE_KHR:
+			m_SwapchainOutOfDate = true;
+			return INVALID_SWAPCHAIN_IMAGE_INDEX;
+		default:
+			PXL8_CORE_ERROR("Failed to acquire swapchain image!");
+			return INVALID_SWAPCHAIN_IMAGE_INDEX;
+		}
 	}
 
-	void PixelatePresentationEngine::TransitionImageLayout(
-		uint32_t swapchainImageIndex,
-		VkSemaphoreSubmitInfo* pSignalSemaphore,
-		uint32_t signalSemaphoreCount,
-		VkSemaphoreSubmitInfo* pWaitSemaphore,
-		uint32_t waitSemaphoreCount,
-		VkImageLayout newLayout,
-		VkImageLayout oldLayout)
+	// True if the swapchain has to be recreated, suboptimal and out of date presents still consume their semaphores
+	static bool ValidateSwapchainResult(VkResult result)
 	{
-		// Don't re-record the command buffer, it'll be the same every frame
-		if (m_ImageTransitionCommandBuffers[swapchainImageIndex] == VK_NULL_HANDLE)
+		switch (result)
 		{
-			m_ImageTransitionCommandBuffers[swapchainImageIndex] = CommandBufferManager::GetCommandBuffer(m_Device);
-
-			VkImageMemoryBarrier2 barrier{};
-			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
-			barrier.oldLayout = oldLayout;
-			barrier.newLayout = newLayout;
-			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-			barrier.image = m_Swapchain.SwapchainImages[swapchainImageIndex];
-			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			barrier.subresourceRange.baseMipLevel = 0;
-			barrier.subresourceRange.levelCount = 1;
-			barrier.subresourceRange.baseArrayLayer = 0;
-			barrier.subresourceRange.layerCount = 1;
-
-			barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT;
-			barrier.srcAccessMask = 0;
-			barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE_KHR;
-			barrier.dstAccessMask = 0;
-
-			VkDependencyInfo dependencyInfo{};
-			dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-			dependencyInfo.imageMemoryBarrierCount = 1;
-			dependencyInfo.pImageMemoryBarriers = &barrier;
-
-			VkCommandBufferBeginInfo commandBufferBeginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
-			commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-
-			vkBeginCommandBuffer(m_ImageTransitionCommandBuffers[swapchainImageIndex], &commandBufferBeginInfo);
-			vkCmdPipelineBarrier2(m_ImageTransitionCommandBuffers[swapchainImageIndex], &dependencyInfo);
-			vkEndCommandBuffer(m_ImageTransitionCommandBuffers[swapchainImageIndex]);
+		case VK_SUCCESS:
+			return false;
+		case VK_SUBOPTIMAL_KHR:
+		case VK_ERROR_OUT_OF_DATE_KHR:
+			return true;
+		case VK_ERROR_DEVICE_LOST:
+			PXL8_CORE_ERROR("Device was lost during swapchain presentation!");
+			return false;
+		default:
+			PXL8_CORE_ERROR("Unknown error during present queue submission!");
+			return false;
 		}
-
-		QueueManager::GraphicsQueueSubmit(
-			m_Device,
-			GraphicsQueueSubmitDescriptor{ GraphicsQueueType::Default },
-			m_ImageTransitionCommandBuffers[swapchainImageIndex],
-			VK_NULL_HANDLE,
-			pSignalSemaphore, signalSemaphoreCount,
-			pWaitSemaphore, waitSemaphoreCount
-		);
 	}
 
 	void PixelatePresentationEngine::Present(
 		uint32_t swapchainImageIndex,
 		VkSemaphoreSubmitInfo* pWaitSemaphore,
-		uint32_t waitSemaphoreCount,
-		VkImageLayout previousLayout)
+		uint32_t waitSemaphoreCount)
 	{
+		PXL8_PROFILE_SCOPE("PixelatePresentationEngine::Present");
+
+		if (IsHeadless())
+		{
+			// Nothing is shown, the wait only unsignals the semaphores so they can be signaled again
+			VkSubmitInfo2 submitInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+				.waitSemaphoreInfoCount = waitSemaphoreCount,
+				.pWaitSemaphoreInfos = pWaitSemaphore,
+			};
+
+			if (waitSemaphoreCount > 0)
+				QueueManager::GraphicsQueueSubmit(m_Device, GraphicsQueueSubmitDescriptor(), &submitInfo, 1, VK_NULL_HANDLE);
+
+			return;
+		}
+
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		presentInfo.swapchainCount = 1;
 		presentInfo.pSwapchains = &m_Swapchain.VkSwapchain;
 		presentInfo.pImageIndices = &swapchainImageIndex;
 
+		// The render graph transitions the image to the present layout, only wait for it to finish
 		std::vector<VkSemaphore> waitSemaphores{};
-
-		//if (!(previousLayout & (VK_IMAGE_LAYOUT_PRESENT_SRC_KHR | VK_IMAGE_LAYOUT_SHARED_PRESENT_KHR)))
-		//{
-			auto& imageTransitionSemaphore = SemaphoreManager::GetSemaphore(
-				m_Device.VkDevice,
-				VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-				SemaphoreDescriptor
-				{
-					.Identifier = SemaphoreIdentifier::SwapchainImageTransitionToPresent,
-					.Index = swapchainImageIndex
-				});
-
-			TransitionImageLayout(
-				swapchainImageIndex,
-				&imageTransitionSemaphore.SemaphoreSubmitInfo, 1,
-				0, 0);
-
-			waitSemaphores.push_back(imageTransitionSemaphore);
-		//}
-		//else
-		//{
-			//waitSemaphores.push_back(acquireSwapchainImageSemaphore);
-		//}
+		waitSemaphores.reserve(waitSemaphoreCount);
+		for (uint32_t i = 0; i < waitSemaphoreCount; i++)
+			waitSemaphores.push_back(pWaitSemaphore[i].semaphore);
 
 		presentInfo.waitSemaphoreCount = waitSemaphores.size();
 		presentInfo.pWaitSemaphores = waitSemaphores.data();
 
-		ValidateSwapchainResult(vkQueuePresentKHR(m_PresentQueue, &presentInfo));
+		if (ValidateSwapchainResult(QueueManager::QueuePresent(m_PresentQueue, &presentInfo)))
+			m_SwapchainOutOfDate = true;
+	}
+
+	bool PixelatePresentationEngine::IsSwapchainOutOfDate() const
+	{
+		if (m_SwapchainOutOfDate)
+			return true;
+
+		// Not every platform reports a resize through acquire or present
+		if (IsHeadless())
+			return false;
+
+		auto drawableExtent = GetDrawableExtent(m_Window);
+		return drawableExtent.width != m_DrawableExtent.width || drawableExtent.height != m_DrawableExtent.height;
+	}
+
+	void PixelatePresentationEngine::ResizeSurface(int width, int height)
+	{
+		if (!IsHeadless())
+		{
+			SDL_SetWindowSize(m_Window, width, height);
+			return;
+		}
+
+		m_Width = width;
+		m_Height = height;
+		m_SwapchainOutOfDate = true;
+	}
+
+	bool PixelatePresentationEngine::RecreateSwapchain(TimelinePoint retireAfter)
+	{
+		RetiredSwapchain retired{};
+		auto headlessExtent = VkExtent2D{ static_cast<uint32_t>(m_Width), static_cast<uint32_t>(m_Height) };
+
+		if (!m_Swapchain.Recreate(m_Window, headlessExtent, retired))
+			return false;
+
+		// Images of frames still in flight stay alive until those frames complete
+		retired.RetireAfter = retireAfter;
+		m_RetiredSwapchains.push_back(std::move(retired));
+
+		m_Width = static_cast<int>(m_Swapchain.Extent.width);
+		m_Height = static_cast<int>(m_Swapchain.Extent.height);
+		m_NextOffscreenImage = 0;
+		m_SwapchainOutOfDate = false;
+		if (!IsHeadless())
+			m_DrawableExtent = GetDrawableExtent(m_Window);
+		m_SwapchainGeneration++;
+
+		PXL8_CORE_TRACE("Swapchain recreated at " + std::to_string(m_Width) + "x" + std::to_string(m_Height) + ".");
+
+		return true;
+	}
+
+	void PixelatePresentationEngine::DisposeRetiredSwapchains()
+	{
+		// Retired in submission order, so the first incomplete one ends the search
+		size_t disposedCount = 0;
+		for (; disposedCount < m_RetiredSwapchains.size(); disposedCount++)
+		{
+			if (!TimelineManager::IsComplete(m_RetiredSwapchains[disposedCount].RetireAfter))
+				break;
+
+			m_Swapchain.DisposeRetired(m_RetiredSwapchains[disposedCount]);
+		}
+
+		m_RetiredSwapchains.erase(m_RetiredSwapchains.begin(), m_RetiredSwapchains.begin() + disposedCount);
 	}
 
 	void PixelatePresentationEngine::Dispose(VkInstance instance)
 	{
+		// The device is idle by now
+		for (auto& retired : m_RetiredSwapchains)
+			m_Swapchain.DisposeRetired(retired);
+		m_RetiredSwapchains.clear();
+
 		m_Swapchain.Dispose();
-		vkDestroySurfaceKHR(instance, m_VkSurfaceKHR, nullptr);
+
+		if (m_VkSurfaceKHR != VK_NULL_HANDLE)
+			vkDestroySurfaceKHR(instance, m_VkSurfaceKHR, nullptr);
+
 		DestroySDLWindow(m_Window);
 	}
 }
\ No newline at end of file
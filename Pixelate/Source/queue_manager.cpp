@@ -1,5 +1,6 @@
 
 #include <unordered_map>
+#include <mutex>
 
 #include "queue_manager.h"
 #include "hasher.h"
@@ -19,6 +20,19 @@ namespace Pixelate
 	{
 		Hasher hasher{};
 
+		hasher.Hash((uint32_t)VK_QUEUE_COMPUTE_BIT); // shares g_Queues with the graphics queues
+
+		hasher.Hash((uint32_t)Type);
+		hasher.Hash((uint32_t)device);
+
+		return hasher.GetValue();
+	}
+	uint64_t TransferQueueSubmitDescriptor::Hash(VkDevice device)
+	{
+		Hasher hasher{};
+
+		hasher.Hash((uint32_t)VK_QUEUE_TRANSFER_BIT);
+
 		hasher.Hash((uint32_t)Type);
 		hasher.Hash((uint32_t)device);
 
@@ -28,6 +42,32 @@ namespace Pixelate
 	namespace QueueManager
 	{
 		std::unordered_map<uint64_t, VkQueue> g_Queues{};
+		std::unordered_map<VkQueue, std::mutex> g_QueueMutexes{}; // by handle, the fallbacks and the present queue can alias one VkQueue
+		std::mutex g_QueuesMutex; // guards both maps, never held while submitting
+
+		static VkQueue GetQueue(VkDevice device, uint64_t hash, uint32_t queueFamilyIndex, uint32_t queueIndex)
+		{
+			std::lock_guard<std::mutex> lock(g_QueuesMutex);
+
+			auto& queue = g_Queues[hash];
+			if (queue == VK_NULL_HANDLE)
+				vkGetDeviceQueue(device, queueFamilyIndex, queueIndex, &queue);
+
+			return queue;
+		}
+
+		static std::mutex& GetQueueMutex(VkQueue queue)
+		{
+			std::lock_guard<std::mutex> lock(g_QueuesMutex);
+			return g_QueueMutexes[queue];
+		}
+
+		static void QueueSubmit(VkQueue queue, uint32_t submitInfoCount, const VkSubmitInfo2* pSubmitInfos, VkFence signalFence)
+		{
+			// vkQueueSubmit2 needs the queue externally synchronized, uploads submit from other threads than the renderer
+			std::lock_guard<std::mutex> lock(GetQueueMutex(queue));
+			QueueSubmit(queue, submitInfoCount, pSubmitInfos, signalFence);
+		}
 
 		//static void QueueSubmit1(
 		//	const PixelateDevice& device,
@@ -78,11 +118,7 @@ namespace Pixelate
 			VkSemaphoreSubmitInfo* pWaitSemaphores,
 			uint32_t waitSemaphoreCount)
 		{
-			auto hash = descriptor.Hash(device.VkDevice);
-			auto& queue = g_Queues[hash];
-
-			if (queue == VK_NULL_HANDLE)
-				vkGetDeviceQueue(device.VkDevice, device.QueueFamilyIndices.GraphicsQueueFamily.value(), (uint32_t)descriptor.Type, &queue);
+			auto queue = GetQueue(device.VkDevice, descriptor.Hash(device.VkDevice), device.QueueFamilyIndices.GraphicsQueueFamily.value(), (uint32_t)descriptor.Type);
 
 			VkCommandBufferSubmitInfo commandBufferSubmitInfo{};
 			commandBufferSubmitInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
@@ -98,7 +134,7 @@ namespace Pixelate
 			queueSubmitInfo.waitSemaphoreInfoCount = waitSemaphoreCount;
 			queueSubmitInfo.pWaitSemaphoreInfos = pWaitSemaphores;
 
-			vkQueueSubmit2(queue, 1, &queueSubmitInfo, signalFence);
+			QueueSubmit(queue, 1, &queueSubmitInfo, signalFence);
 		}
 
 		void GraphicsQueueSubmit(
@@ -111,14 +147,10 @@ namespace Pixelate
 			VkSemaphoreSubmitInfo* pWaitSemaphores,
 			uint32_t waitSemaphoreCount)
 		{
-			auto hash = descriptor.Hash(device.VkDevice);
-			auto& queue = g_Queues[hash];
-
-			if (queue == VK_NULL_HANDLE)
-				vkGetDeviceQueue(device.VkDevice, device.QueueFamilyIndices.GraphicsQueueFamily.value(), (uint32_t)descriptor.Type, &queue);
+			auto queue = GetQueue(device.VkDevice, descriptor.Hash(device.VkDevice), device.QueueFamilyIndices.GraphicsQueueFamily.value(), (uint32_t)descriptor.Type);
 
 			std::vector<VkCommandBufferSubmitInfo> commandBufferSubmitInfos{};
-			commandBufferSubmitInfos.resize(commandBuffers.size());
+			commandBufferSubmitInfos.reserve(commandBuffers.size());
 
 			for (const auto& commandBuffer : commandBuffers)
 			{
@@ -127,7 +159,7 @@ namespace Pixelate
 						VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
 						nullptr,
 						commandBuffer,
-						0xFFFFFFFF
+						0b1
 					});
 			}
 
@@ -140,7 +172,75 @@ namespace Pixelate
 			queueSubmitInfo.waitSemaphoreInfoCount = waitSemaphoreCount;
 			queueSubmitInfo.pWaitSemaphoreInfos = pWaitSemaphores;
 
-			vkQueueSubmit2(queue, 1, &queueSubmitInfo, signalFence);
+			QueueSubmit(queue, 1, &queueSubmitInfo, signalFence);
+		}
+
+		void GraphicsQueueSubmit(
+			PixelateDevice device,
+			GraphicsQueueSubmitDescriptor descriptor,
+			const VkSubmitInfo2* pSubmitInfos,
+			uint32_t submitInfoCount,
+			VkFence signalFence)
+		{
+			auto queue = GetQueue(device.VkDevice, descriptor.Hash(device.VkDevice), device.QueueFamilyIndices.GraphicsQueueFamily.value(), (uint32_t)descriptor.Type);
+
+			QueueSubmit(queue, submitInfoCount, pSubmitInfos, signalFence);
+		}
+
+		void ComputeQueueSubmit(
+			PixelateDevice device,
+			ComputeQueueSubmitDescriptor descriptor,
+			const VkSubmitInfo2* pSubmitInfos,
+			uint32_t submitInfoCount,
+			VkFence signalFence)
+		{
+			if (!device.QueueFamilyIndices.HasAsyncCompute())
+			{
+				GraphicsQueueSubmit(device, GraphicsQueueSubmitDescriptor(), pSubmitInfos, submitInfoCount, signalFence);
+				return;
+			}
+
+			auto queue = GetQueue(device.VkDevice, descriptor.Hash(device.VkDevice), device.QueueFamilyIndices.ComputeQueueFamily.value(), (uint32_t)descriptor.Type);
+
+			QueueSubmit(queue, submitInfoCount, pSubmitInfos, signalFence);
+		}
+
+		void TransferQueueSubmit(
+			PixelateDevice device,
+			TransferQueueSubmitDescriptor descriptor,
+			const VkSubmitInfo2* pSubmitInfos,
+			uint32_t submitInfoCount,
+			VkFence signalFence)
+		{
+			if (!device.QueueFamilyIndices.HasDedicatedTransfer())
+			{
+				GraphicsQueueSubmit(device, GraphicsQueueSubmitDescriptor(), pSubmitInfos, submitInfoCount, signalFence);
+				return;
+			}
+
+			auto queue = GetQueue(device.VkDevice, descriptor.Hash(device.VkDevice), device.QueueFamilyIndices.TransferQueueFamily.value(), (uint32_t)descriptor.Type);
+
+			QueueSubmit(queue, submitInfoCount, pSubmitInfos, signalFence);
+		}
+
+		VkResult QueuePresent(VkQueue queue, const VkPresentInfoKHR* pPresentInfo)
+		{
+			std::lock_guard<std::mutex> lock(GetQueueMutex(queue));
+			return vkQueuePresentKHR(queue, pPresentInfo);
+		}
+
+		void DeviceWaitIdle(VkDevice device)
+		{
+			// vkDeviceWaitIdle needs every queue externally synchronized. Locked in map order while the map can't change,
+			// a submit never holds more than its own queue's mutex.
+			std::lock_guard<std::mutex> lock(g_QueuesMutex);
+
+			std::vector<std::unique_lock<std::mutex>> queueLocks{};
+			queueLocks.reserve(g_QueueMutexes.size());
+			for (auto& [queue, queueMutex] : g_QueueMutexes)
+				queueLocks.emplace_back(queueMutex);
+
+			vkDeviceWaitIdle(device);
 		}
 	}
 }
@@ -1,41 +1,215 @@
+#include <latch>
 #include "render_graph.h"
 #include "log.h"
 #include "command_buffer_manager.h"
 #include "queue_manager.h"
+#include "hasher.h"
+#include "worker_pool.h"
+#include "cpu_profiler.h"
 
 namespace Pixelate
 {
+	std::unique_ptr<WorkerPool> g_PassRecordingPool;
+
+	static WorkerPool& GetPassRecordingPool()
+	{
+		if (!g_PassRecordingPool)
+		{
+			auto threadCount = PixelateSettings::PASS_RECORDING_THREAD_COUNT > 0 ? PixelateSettings::PASS_RECORDING_THREAD_COUNT : WorkerPool::GetDefaultThreadCount();
+			g_PassRecordingPool = std::make_unique<WorkerPool>("PassRecording", threadCount);
+		}
+
+		return *g_PassRecordingPool;
+	}
+
+	static bool IsSwapchainOutput(const PixelatePass& pass, const PixelateResourceUsage& usage)
+	{
+		return (pass.Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN) && (usage.UsageFlags & PIXELATE_USAGE_COLOR_ATTACMENT);
+	}
+
+	static VkImageUsageFlags GetImageUsageFlags(PixelateResourceUsageFlag usageFlags)
+	{
+		VkImageUsageFlags imageUsage = 0;
+
+		if (usageFlags & PIXELATE_USAGE_COLOR_ATTACMENT)
+			imageUsage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		if (usageFlags & PIXELATE_USAGE_DEPTH_ATTACMENT)
+			imageUsage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		if (usageFlags & PIXELATE_USAGE_SAMPLED_TEXTURE_BUFFER)
+			imageUsage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		if (usageFlags & PIXELATE_USAGE_STORAGE_BUFFER)
+			imageUsage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+		return imageUsage;
+	}
+
+	static VkBufferUsageFlags GetBufferUsageFlags(PixelateResourceUsageFlag usageFlags)
+	{
+		VkBufferUsageFlags bufferUsage = 0;
+
+		if (usageFlags & PIXELATE_USAGE_INDEX_BUFFER)
+			bufferUsage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+		if (usageFlags & PIXELATE_USAGE_VERTEX_BUFFER)
+			bufferUsage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		if (usageFlags & PIXELATE_USAGE_STORAGE_BUFFER)
+			bufferUsage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+		return bufferUsage;
+	}
+
+	// Every non-swapchain resource named by the passes, with the range of passes it is alive in
+	static std::vector<TransientResourceDescriptor> GetTransientResourceDescriptors(
+		const std::vector<PixelatePass>& passes,
+		const PixelateSwapchain& swapchain,
+		const std::vector<TimelineQueue>& passQueues)
+	{
+		std::vector<TransientResourceDescriptor> descriptors{};
+		std::vector<PixelateResourceUsageFlag> usageFlags{};
+		std::vector<PixelateResource> resources{};
+		std::vector<bool> usedOnComputeQueue{};
+		std::map<std::string, size_t> descriptorIndices{};
+
+		for (uint32_t i = 0; i < passes.size(); i++)
+		{
+			auto addUsage = [&](const PixelateResourceUsage& usage, bool isOutput)
+			{
+				if (IsSwapchainOutput(passes[i], usage))
+					return;
+
+				auto [descriptorIndex, inserted] = descriptorIndices.try_emplace(usage.Resource.Name, descriptors.size());
+				if (inserted)
+				{
+					descriptors.push_back(TransientResourceDescriptor
+						{
+							.Name = usage.Resource.Name,
+							.Type = usage.Resource.Type,
+							.FirstPass = i,
+							.CanAlias = isOutput, // inputs come first, so this is only true if the first pass doesn't read it
+						});
+					usageFlags.push_back(PIXELATE_USAGE_NONE);
+					resources.push_back(usage.Resource);
+					usedOnComputeQueue.push_back(false);
+				}
+
+				descriptors[descriptorIndex->second].LastPass = i;
+				usageFlags[descriptorIndex->second] |= usage.UsageFlags;
+				usedOnComputeQueue[descriptorIndex->second] = usedOnComputeQueue[descriptorIndex->second] || passQueues[i] == TimelineQueue::Compute;
+
+				if (usage.UsageFlags & PIXELATE_USAGE_DEPTH_ATTACMENT)
+					descriptors[descriptorIndex->second].ImageAspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+			};
+
+			for (const auto& usage : passes[i].Inputs)
+				addUsage(usage, false);
+			for (const auto& usage : passes[i].Outputs)
+				addUsage(usage, true);
+		}
+
+		for (size_t i = 0; i < descriptors.size(); i++)
+		{
+			auto& descriptor = descriptors[i];
+			constexpr PixelateResourceUsageFlag attachmentUsage = PIXELATE_USAGE_COLOR_ATTACMENT | PIXELATE_USAGE_DEPTH_ATTACMENT;
+
+			// Lifetimes follow graph order, which the two queues don't keep to
+			if (usedOnComputeQueue[i])
+				descriptor.CanAlias = false;
+
+			if (descriptor.Type == PixelateResourceType::Buffer)
+			{
+				descriptor.BufferCreateInfo = VkBufferCreateInfo
+				{
+					.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+					.size = resources[i].PhysicalBufferDescriptor.Size,
+					.usage = GetBufferUsageFlags(usageFlags[i]),
+					.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+				};
+				continue;
+			}
+
+			// Zero width or height means the resource follows the swapchain extent
+			const auto& imageDescriptor = resources[i].PhysicalImageDescriptor;
+			descriptor.ImageCreateInfo = VkImageCreateInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+				.imageType = VK_IMAGE_TYPE_2D,
+				.format = imageDescriptor.Format,
+				.extent =
+				{
+					imageDescriptor.Width ? imageDescriptor.Width : swapchain.Extent.width,
+					imageDescriptor.Height ? imageDescriptor.Height : swapchain.Extent.height,
+					1,
+				},
+				.mipLevels = 1,
+				.arrayLayers = 1,
+				.samples = VK_SAMPLE_COUNT_1_BIT,
+				.tiling = VK_IMAGE_TILING_OPTIMAL,
+				.usage = GetImageUsageFlags(usageFlags[i]),
+				.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+				.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			};
+
+			// Written and consumed inside one pass, the contents never have to leave tile memory
+			descriptor.IsTransientAttachment = descriptor.CanAlias
+				&& descriptor.FirstPass == descriptor.LastPass
+				&& (usageFlags[i] & ~attachmentUsage) == 0;
+		}
+
+		return descriptors;
+	}
+
 	static PixelateRenderingInfo GetRenderingInfo(
 		const PixelatePass& pass,
 		const size_t index,
+		const TransientResourceSet& transientResources,
 		const PixelateSwapchain& swapchain)
 	{
 		PixelateRenderingInfo renderingInfo{};
-
-		if (!(pass.Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN))
-		{
-			PXL8_CORE_WARN("Non-swapchain render targets are not currently supported! Rendering to swapchain...");
-		}
+		VkExtent2D renderExtent = swapchain.Extent;
 
 		for (int i = 0; i < pass.Outputs.size(); i++)
 		{
-			if (pass.Outputs[i].UsageFlags & PIXELATE_USAGE_COLOR_ATTACMENT) // only color attachment is supported for now...
+			const auto& output = pass.Outputs[i];
+			auto isSwapchainOutput = IsSwapchainOutput(pass, output);
+			auto pResource = isSwapchainOutput ? nullptr : transientResources.Find(output.Resource.Name);
+
+			if (!isSwapchainOutput && pResource == nullptr)
+				continue;
+
+			if (pResource != nullptr && pResource->Type == PixelateResourceType::Image)
+				renderExtent = pResource->Extent;
+
+			// Transient attachments are consumed within the pass, storing them would defeat lazily allocated memory
+			auto storeOp = pResource != nullptr && pResource->IsTransientAttachment ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+
+			if (output.UsageFlags & PIXELATE_USAGE_COLOR_ATTACMENT)
 			{
 				renderingInfo.ColorAttachments.push_back(
 					VkRenderingAttachmentInfo
 					{
 						.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
-						.imageView = VK_NULL_HANDLE, // swapchain image views are retrieved at runtime
+						.imageView = pResource != nullptr ? pResource->ImageView : VK_NULL_HANDLE, // swapchain image views are retrieved at runtime
 						.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
 						.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-						.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+						.storeOp = storeOp,
 						.clearValue = { .color = { 1.0f, 0.0f, 1.0f, 1.0f } },
 					});
 			}
+			else if (output.UsageFlags & PIXELATE_USAGE_DEPTH_ATTACMENT)
+			{
+				renderingInfo.DepthAttachment = VkRenderingAttachmentInfo
+				{
+					.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+					.imageView = pResource->ImageView,
+					.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+					.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+					.storeOp = storeOp,
+					.clearValue = { .depthStencil = { 1.0f, 0 } },
+				};
+			}
 		}
 
 		renderingInfo.RenderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
-		renderingInfo.RenderingInfo.renderArea = { 0, 0, swapchain.Extent.width, swapchain.Extent.height };
+		renderingInfo.RenderingInfo.renderArea = { 0, 0, renderExtent.width, renderExtent.height };
 		renderingInfo.RenderingInfo.layerCount = 1;
 		renderingInfo.RenderingInfo.colorAttachmentCount = renderingInfo.ColorAttachments.size();
 		renderingInfo.RenderingInfo.pColorAttachments = renderingInfo.ColorAttachments.data();
@@ -45,23 +219,52 @@ namespace Pixelate
 		return renderingInfo;
 	}
 
-	static PixelateRuntimePass BuildGraphicsPass(PixelateDevice device, const PixelatePass& pass, const PixelateSwapchain& swapchain)
+	static void SetAttachmentFormats(PixelateRuntimePass& runtimePass, const PixelatePass& pass, VkFormat swapchainFormat)
 	{
-		PixelateRuntimePass runtimePass{};
+		runtimePass.ColorAttachmentFormats.clear();
+		runtimePass.DepthAttachmentFormat = VK_FORMAT_UNDEFINED;
 
-		VkViewport viewport{};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)swapchain.Extent.width;
-		viewport.height = (float)swapchain.Extent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+		for (const auto& output : pass.Outputs)
+		{
+			if (output.Resource.Type == PixelateResourceType::Buffer)
+				continue;
+
+			auto format = IsSwapchainOutput(pass, output) ? swapchainFormat : output.Resource.PhysicalImageDescriptor.Format;
 
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapchain.Extent;
+			if (output.UsageFlags & PIXELATE_USAGE_COLOR_ATTACMENT)
+				runtimePass.ColorAttachmentFormats.push_back(format);
+			else if (output.UsageFlags & PIXELATE_USAGE_DEPTH_ATTACMENT)
+				runtimePass.DepthAttachmentFormat = format;
+		}
+	}
 
-		runtimePass.Pipeline = Pipelines::GetGraphicsPipeline(device.VkDevice, pass, viewport, scissor, swapchain.SurfaceFormat.format);
+	// Images with a zero width or height are sized like the swapchain, see GetTransientResourceDescriptors
+	static bool HasSwapchainSizedResources(const std::vector<PixelatePass>& passes)
+	{
+		for (const auto& pass : passes)
+			for (const auto* usages : { &pass.Inputs, &pass.Outputs })
+				for (const auto& usage : *usages)
+					if (!IsSwapchainOutput(pass, usage)
+						&& usage.Resource.Type == PixelateResourceType::Image
+						&& (usage.Resource.PhysicalImageDescriptor.Width == 0 || usage.Resource.PhysicalImageDescriptor.Height == 0))
+						return true;
+
+		return false;
+	}
+
+	static PixelateRuntimePass BuildGraphicsPass(
+		PixelateDevice device,
+		const PixelatePass& pass,
+		const TransientResourceSet& transientResources,
+		const PixelateSwapchain& swapchain)
+	{
+		PixelateRuntimePass runtimePass{};
+
+		// Viewport and scissor are dynamic, resizes don't need new pipelines
+		runtimePass.Pipeline = Pipelines::RequestGraphicsPipeline(device.VkDevice, pass, swapchain.SurfaceFormat.format);
+		runtimePass.DynamicState = Pipelines::GetDynamicState(pass.GraphicsPipelineDescriptor);
+		runtimePass.BindsDescriptorHeap = Pipelines::UsesBindlessLayout(pass.GraphicsPipelineDescriptor);
+		runtimePass.PipelineLayout = Pipelines::GetPipelineLayout(device.VkDevice, pass.GraphicsPipelineDescriptor);
 
 		runtimePass.PassType = pass.PassType;
 		runtimePass.Device = device.VkDevice;
@@ -69,25 +272,16 @@ namespace Pixelate
 		runtimePass.Flags = pass.Flags;
 
 		for (int i = 0; i < PixelateSettings::MAX_FRAMES_IN_FLIGHT; i++)
-		{
-			runtimePass.CommandBuffer[i] = CommandBufferManager::GetCommandBuffer(
-				device,
-				CommandBufferDescriptor
-				{
-					.Type = CommandBufferType::GraphicsQueue,
-					.Level = VkCommandBufferLevel::VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-					.PerformanceProfile = pass.Flags & PIXELATE_PASS_RECORD_ONCE
-						? CommandBufferPerformanceProfile::PersistentResources
-						: CommandBufferPerformanceProfile::Default,
-				});
+			runtimePass.RenderingInfos[i] = GetRenderingInfo(pass, i, transientResources, swapchain);
 
-			runtimePass.RenderingInfos[i] = GetRenderingInfo(pass, i, swapchain);
-		}
+		SetAttachmentFormats(runtimePass, pass, swapchain.SurfaceFormat.format);
 
 		switch (pass.PassType)
 		{
 		case PassType::Graphics:
 			runtimePass.CommandBufferGraphics = pass.CommandBufferGraphics;
+			runtimePass.CommandBufferGraphicsSlice = pass.CommandBufferGraphicsSlice;
+			runtimePass.SliceCount = std::max(pass.SliceCount, 1u);
 			break;
 		case PassType::Host:
 			runtimePass.CommandBufferHost = pass.CommandBufferHost;
@@ -97,7 +291,72 @@ namespace Pixelate
 		return runtimePass;
 	}
 
-	RenderGraph::RenderGraph(PixelateDevice device, const RenderGraphDescriptor& renderGraphDescriptor, const PixelateSwapchain& swapchain)
+	static PixelateRuntimePass BuildComputePass(PixelateDevice device, const PixelatePass& pass, TimelineQueue queue)
+	{
+		PixelateRuntimePass runtimePass{};
+
+		runtimePass.Pipeline = Pipelines::RequestComputePipeline(device.VkDevice, pass);
+		runtimePass.BindsDescriptorHeap = Pipelines::UsesBindlessLayout(pass.ComputePipelineDescriptor);
+		runtimePass.PipelineLayout = Pipelines::GetPipelineLayout(device.VkDevice, pass.ComputePipelineDescriptor);
+		runtimePass.PassType = pass.PassType;
+		runtimePass.Device = device.VkDevice;
+		runtimePass.PassName = pass.Name;
+		runtimePass.Flags = pass.Flags;
+		runtimePass.Queue = queue;
+		runtimePass.CommandBufferCompute = pass.CommandBufferCompute;
+
+		return runtimePass;
+	}
+
+	static std::vector<PixelatePassResource> ResolvePassResources(const std::vector<PixelateResourceUsage>& usages, const TransientResourceSet& transientResources)
+	{
+		std::vector<PixelatePassResource> resources{};
+		resources.reserve(usages.size());
+
+		for (const auto& usage : usages)
+		{
+			auto pResource = transientResources.Find(usage.Resource.Name);
+			resources.push_back(PixelatePassResource
+			{
+				.Name = usage.Resource.Name,
+				.UsageFlags = usage.UsageFlags,
+				.Resource = pResource != nullptr ? *pResource : TransientResource{},
+			});
+		}
+
+		return resources;
+	}
+
+	static void ResolveBarrierResources(PixelatePassBarriers& barriers, const TransientResourceSet& transientResources)
+	{
+		for (size_t i = 0; i < barriers.ImageBarriers.size(); i++)
+		{
+			if (barriers.ImageBarrierResources[i] == nullptr)
+				continue; // swapchain image, resolved when recording
+
+			auto pResource = transientResources.Find(barriers.ImageBarrierResources[i]);
+			barriers.ImageBarriers[i].image = pResource != nullptr ? pResource->Image : VK_NULL_HANDLE;
+		}
+
+		for (size_t i = 0; i < barriers.BufferBarriers.size(); i++)
+		{
+			auto pResource = transientResources.Find(barriers.BufferBarrierResources[i]);
+			barriers.BufferBarriers[i].buffer = pResource != nullptr ? pResource->Buffer : VK_NULL_HANDLE;
+		}
+	}
+
+	static uint32_t GetQueueFamilyIndex(const PixelateDevice& device, TimelineQueue queue)
+	{
+		return queue == TimelineQueue::Compute ? device.QueueFamilyIndices.ComputeQueueFamily.value() : device.QueueFamilyIndices.GraphicsQueueFamily.value();
+	}
+
+	static CommandBufferType GetCommandBufferType(const PixelateRuntimePass& runtimePass)
+	{
+		return runtimePass.Queue == TimelineQueue::Compute ? CommandBufferType::ComputeQueue : CommandBufferType::GraphicsQueue;
+	}
+
+	RenderGraph::RenderGraph(PixelateDevice device, VulkanResourceManager& resourceManager, const RenderGraphDescriptor& renderGraphDescriptor, const PixelateSwapchain& swapchain)
+		: m_BuildStart(std::chrono::steady_clock::now())
 	{
 		if (!RuntimePasses.empty())
 			RuntimePasses.clear();
@@ -106,135 +365,757 @@ namespace Pixelate
 
 		auto& passes = renderGraphDescriptor.Passes;
 
+		m_Schedule = RenderGraphScheduler::Schedule(passes, PixelateSettings::ASYNC_COMPUTE && device.QueueFamilyIndices.HasAsyncCompute());
+
+		m_TransientResources = resourceManager.AllocateTransientResources(GetTransientResourceDescriptors(passes, swapchain, m_Schedule.PassQueues));
+
+		std::map<std::string, std::string> aliasPredecessors{};
+		for (const auto& [name, resource] : m_TransientResources.Resources)
+			if (resource.AliasPredecessor != nullptr)
+				aliasPredecessors.insert(std::make_pair(name, std::string(resource.AliasPredecessor)));
+
 		for (int i = 0; i < renderGraphDescriptor.Passes.size(); i++)
 		{
 			switch (passes[i].PassType)
 			{
 			case PassType::Graphics:
-				RuntimePasses[i] = BuildGraphicsPass(device, passes[i], swapchain);
+				RuntimePasses[i] = BuildGraphicsPass(device, passes[i], m_TransientResources, swapchain);
+				break;
+			case PassType::Compute:
+				RuntimePasses[i] = BuildComputePass(device, passes[i], m_Schedule.PassQueues[i]);
 				break;
 			}
 		}
+
+		// Ownership transfers are only needed once passes use different queue families
+		std::vector<uint32_t> passQueueFamilies{};
+		if (m_Schedule.HasAsyncCompute())
+			for (auto queue : m_Schedule.PassQueues)
+				passQueueFamilies.push_back(GetQueueFamilyIndex(device, queue));
+
+		auto barriers = RenderGraphBarriers::Synthesize(passes, aliasPredecessors, passQueueFamilies);
+
+		for (int i = 0; i < RuntimePasses.size(); i++)
+		{
+			RuntimePasses[i].BarriersBeforePass = std::move(barriers.BeforePass[i]);
+			RuntimePasses[i].BarriersAfterPass = std::move(barriers.AfterPass[i]);
+			ResolveBarrierResources(RuntimePasses[i].BarriersBeforePass, m_TransientResources);
+			ResolveBarrierResources(RuntimePasses[i].BarriersAfterPass, m_TransientResources);
+			RuntimePasses[i].Inputs = ResolvePassResources(passes[i].Inputs, m_TransientResources);
+			RuntimePasses[i].Outputs = ResolvePassResources(passes[i].Outputs, m_TransientResources);
+		}
+
+		m_GpuPassTimings.resize(RuntimePasses.size());
+		for (size_t i = 0; i < RuntimePasses.size(); i++)
+			m_GpuPassTimings[i].PassName = RuntimePasses[i].PassName;
+
+		m_Passes = passes;
+		m_SwapchainExtent = swapchain.Extent;
+		m_SwapchainFormat = swapchain.SurfaceFormat.format;
+	}
+
+	void RenderGraph::OnSwapchainRecreated(PixelateDevice device, VulkanResourceManager& resourceManager, const PixelateSwapchain& swapchain, TimelinePoint retireAfter)
+	{
+		PXL8_PROFILE_SCOPE("RenderGraph::OnSwapchainRecreated");
+
+		auto extentChanged = swapchain.Extent.width != m_SwapchainExtent.width || swapchain.Extent.height != m_SwapchainExtent.height;
+		auto formatChanged = swapchain.SurfaceFormat.format != m_SwapchainFormat;
+
+		// Only resources that follow the swapchain extent are reallocated, together with the rest of their aliasing set.
+		// The old ones stay alive for the frames still in flight.
+		if (extentChanged && HasSwapchainSizedResources(m_Passes))
+		{
+			resourceManager.RetireTransientResources(m_TransientResources, retireAfter);
+			m_TransientResources = resourceManager.AllocateTransientResources(GetTransientResourceDescriptors(m_Passes, swapchain, m_Schedule.PassQueues));
+
+			for (size_t i = 0; i < RuntimePasses.size(); i++)
+			{
+				auto& runtimePass = RuntimePasses[i];
+				ResolveBarrierResources(runtimePass.BarriersBeforePass, m_TransientResources);
+				ResolveBarrierResources(runtimePass.BarriersAfterPass, m_TransientResources);
+				runtimePass.Inputs = ResolvePassResources(m_Passes[i].Inputs, m_TransientResources);
+				runtimePass.Outputs = ResolvePassResources(m_Passes[i].Outputs, m_TransientResources);
+			}
+		}
+
+		for (size_t i = 0; i < RuntimePasses.size(); i++)
+		{
+			if (RuntimePasses[i].PassType != PassType::Graphics)
+				continue;
+
+			auto& runtimePass = RuntimePasses[i];
+
+			for (int frame = 0; frame < PixelateSettings::MAX_FRAMES_IN_FLIGHT; frame++)
+				runtimePass.RenderingInfos[frame] = GetRenderingInfo(m_Passes[i], frame, m_TransientResources, swapchain);
+
+			// The viewport is dynamic, only a new swapchain format needs other pipelines
+			if (formatChanged && (runtimePass.Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN))
+			{
+				runtimePass.Pipeline = Pipelines::RequestGraphicsPipeline(device.VkDevice, m_Passes[i], swapchain.SurfaceFormat.format);
+				SetAttachmentFormats(runtimePass, m_Passes[i], swapchain.SurfaceFormat.format);
+			}
+		}
+
+		m_SwapchainExtent = swapchain.Extent;
+		m_SwapchainFormat = swapchain.SurfaceFormat.format;
+
+		InvalidateRecordedPasses();
 	}
 
-	static void RecordGraphicsPass(
+	bool RenderGraph::ArePipelinesReady() const
+	{
+		for (const auto& runtimePass : RuntimePasses)
+			if (runtimePass.Pipeline.IsValid() && !runtimePass.Pipeline.IsReady())
+				return false;
+
+		return true;
+	}
+
+	void RenderGraph::WaitForPipelines() const
+	{
+		for (const auto& runtimePass : RuntimePasses)
+			runtimePass.Pipeline.Wait(); // returns right away for passes without a pipeline
+	}
+
+	void RenderGraph::InvalidateRecordedPasses()
+	{
+		m_ResourceGeneration++;
+	}
+
+	static uint64_t GetRecordedStateHash(const PixelateRuntimePass& runtimePass, VkImageView swapchainImageView, VkExtent2D extent, uint64_t resourceGeneration)
+	{
+		Hasher hasher;
+
+		hasher.Hash(reinterpret_cast<uint64_t>(runtimePass.Pipeline.Get()));
+		hasher.Hash(reinterpret_cast<uint64_t>(swapchainImageView));
+		hasher.Hash(extent.width);
+		hasher.Hash(extent.height);
+		hasher.Hash(resourceGeneration);
+
+		return hasher.GetValue();
+	}
+
+	static PixelateRecordedCommandBuffer& GetRecordedCommandBuffer(
+		PixelateDevice device,
 		uint32_t frameInFlightIndex,
 		uint32_t swapchainImageIndex,
 		const PixelateSwapchain& swapchain,
 		PixelateRuntimePass& runtimePass)
 	{
-		auto commandBuffer = runtimePass.CommandBuffer[frameInFlightIndex];
-
-		//VkCommandBufferInheritanceRenderingInfo commandBufferInheritanceRenderingInfo
-		//{
-		//	.sType = ,
-		//	.pNext = ,
-		//	.flags = ,
-		//	.viewMask = ,
-		//	.colorAttachmentCount = ,
-		//	.pColorAttachmentFormats = ,
-		//	.depthAttachmentFormat = ,
-		//	.stencilAttachmentFormat = ,
-		//	.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-		//};
-
-		//VkCommandBufferInheritanceInfo commandBufferInheritanceInfo
-		//{
-		//	.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
-		//	.pNext = &commandBufferInheritanceRenderingInfo,
-		//	.renderPass = VK_NULL_HANDLE,
-		//	.subpass = 0,
-		//	.framebuffer = VK_NULL_HANDLE,
-		//	.occlusionQueryEnable = VK_FALSE,
-		//	.queryFlags = 0,
-		//	.pipelineStatistics = 0,
-		//};
+		auto swapchainImageCount = swapchain.SwapchainImages.size();
+		auto index = frameInFlightIndex * swapchainImageCount + swapchainImageIndex;
+
+		// Grows lazily, the swapchain image count is only known once the swapchain exists and may change on recreation
+		auto requiredCount = PixelateSettings::MAX_FRAMES_IN_FLIGHT * swapchainImageCount;
+		if (runtimePass.RecordedCommandBuffers.size() < requiredCount)
+			runtimePass.RecordedCommandBuffers.resize(requiredCount);
+
+		auto& recordedCommandBuffer = runtimePass.RecordedCommandBuffers[index];
+
+		if (recordedCommandBuffer.CommandBuffer == VK_NULL_HANDLE)
+		{
+			recordedCommandBuffer.CommandBuffer = CommandBufferManager::GetCommandBuffer(
+				device,
+				CommandBufferDescriptor
+				{
+					.Type = GetCommandBufferType(runtimePass),
+					.Level = VkCommandBufferLevel::VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+					.PerformanceProfile = CommandBufferPerformanceProfile::PersistentResources,
+				});
+		}
 
+		return recordedCommandBuffer;
+	}
+
+	static PixelatePassContext GetPassContext(
+		VkCommandBuffer commandBuffer,
+		uint32_t passIndex,
+		uint32_t frameInFlightIndex,
+		const PixelateRuntimePass& runtimePass,
+		VkPipeline pipeline)
+	{
+		return PixelatePassContext
+		{
+			.CommandBuffer = commandBuffer,
+			.Pipeline = pipeline,
+			.PipelineLayout = runtimePass.PipelineLayout,
+			.BindPoint = runtimePass.PassType == PassType::Compute ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS,
+			.PassName = runtimePass.PassName,
+			.PassIndex = passIndex,
+			.FrameInFlightIndex = frameInFlightIndex,
+			.SliceIndex = 0,
+			.SliceCount = 1,
+			.Inputs = runtimePass.Inputs,
+			.Outputs = runtimePass.Outputs,
+			.IsRecordedOnce = (runtimePass.Flags & PIXELATE_PASS_RECORD_ONCE) != 0,
+		};
+	}
+
+	// The draws of the pass, a sliced pass recorded into a single command buffer goes through its slices in order
+	static void RecordPassDraws(VkCommandBuffer commandBuffer, uint32_t passIndex, uint32_t frameInFlightIndex, const PixelateRuntimePass& runtimePass, VkPipeline pipeline)
+	{
+		auto context = GetPassContext(commandBuffer, passIndex, frameInFlightIndex, runtimePass, pipeline);
+
+		if (runtimePass.CommandBufferGraphicsSlice == nullptr)
+		{
+			runtimePass.CommandBufferGraphics(context);
+			return;
+		}
+
+		context.SliceCount = runtimePass.SliceCount;
+		for (uint32_t slice = 0; slice < runtimePass.SliceCount; slice++)
+		{
+			context.SliceIndex = slice;
+			runtimePass.CommandBufferGraphicsSlice(context);
+		}
+	}
+
+	// Records the barriers and rendering of the pass, executing the slices' secondary command buffers if there are any
+	static void RecordGraphicsPass(
+		VkCommandBuffer commandBuffer,
+		VkCommandBufferUsageFlags usageFlags,
+		uint32_t passIndex,
+		uint32_t frameInFlightIndex,
+		uint32_t swapchainImageIndex,
+		const PixelateSwapchain& swapchain,
+		PixelateRuntimePass& runtimePass,
+		VkPipeline pipeline,
+		const std::vector<VkCommandBuffer>& secondaryCommandBuffers = {})
+	{
 		VkCommandBufferBeginInfo commandBufferBeginInfo
 		{
 			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
 			.pNext = nullptr,
-			.flags = 0,
-			.pInheritanceInfo = nullptr, //&commandBufferInheritanceInfo,
+			.flags = usageFlags,
+			.pInheritanceInfo = nullptr,
 		};
 		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
 
-		auto colorAttachmentCount = runtimePass.RenderingInfos[frameInFlightIndex].ColorAttachments.size();
+		GpuProfiler::BeginPass(commandBuffer, frameInFlightIndex, passIndex, runtimePass.Queue);
+
+		auto swapchainImage = swapchain.SwapchainImages[swapchainImageIndex];
+		RenderGraphBarriers::Record(commandBuffer, runtimePass.BarriersBeforePass, swapchainImage);
+
+		auto& renderingInfo = runtimePass.RenderingInfos[frameInFlightIndex];
 
-		if (runtimePass.Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN && colorAttachmentCount == 1)
+		if (runtimePass.Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN && renderingInfo.ColorAttachments.size() == 1)
+			renderingInfo.ColorAttachments[0].imageView = swapchain.SwapchainImageViews[swapchainImageIndex];
+
+		// The rendering info is copied around while the graph is built, point it at its own attachments again
+		renderingInfo.RenderingInfo.pColorAttachments = renderingInfo.ColorAttachments.data();
+		renderingInfo.RenderingInfo.pDepthAttachment = renderingInfo.DepthAttachment.has_value() ? &renderingInfo.DepthAttachment.value() : nullptr;
+		renderingInfo.RenderingInfo.pStencilAttachment = renderingInfo.StencilAttachment.has_value() ? &renderingInfo.StencilAttachment.value() : nullptr;
+		renderingInfo.RenderingInfo.flags = secondaryCommandBuffers.empty() ? 0 : VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+
+		vkCmdBeginRendering(commandBuffer, &renderingInfo.RenderingInfo);
+
+		// Until the pipeline is compiled the pass is substituted by a plain clear of its attachments
+		if (!secondaryCommandBuffers.empty())
+			vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryCommandBuffers.size()), secondaryCommandBuffers.data());
+		else if (pipeline != VK_NULL_HANDLE)
 		{
-			runtimePass.RenderingInfos[frameInFlightIndex].ColorAttachments[0].imageView = swapchain.SwapchainImageViews[swapchainImageIndex];
-			runtimePass.RenderingInfos[frameInFlightIndex].RenderingInfo.pColorAttachments = runtimePass.RenderingInfos[frameInFlightIndex].ColorAttachments.data();
+			Pipelines::SetDynamicState(commandBuffer, runtimePass.DynamicState, renderingInfo.RenderingInfo.renderArea);
+			if (runtimePass.BindsDescriptorHeap)
+				BindlessDescriptors::Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS);
+			RecordPassDraws(commandBuffer, passIndex, frameInFlightIndex, runtimePass, pipeline);
 		}
 
-		vkCmdBeginRendering(commandBuffer, &runtimePass.RenderingInfos[frameInFlightIndex].RenderingInfo);
+		vkCmdEndRendering(commandBuffer);
 
-		runtimePass.CommandBufferGraphics(commandBuffer, runtimePass.Pipeline);
+		RenderGraphBarriers::Record(commandBuffer, runtimePass.BarriersAfterPass, swapchainImage);
+
+		GpuProfiler::EndPass(commandBuffer, frameInFlightIndex, passIndex, runtimePass.Queue);
+
+		vkEndCommandBuffer(commandBuffer);
+	}
+
+	static VkCommandBuffer RecordGraphicsPassOnce(
+		PixelateDevice device,
+		uint32_t passIndex,
+		uint32_t frameInFlightIndex,
+		uint32_t swapchainImageIndex,
+		const PixelateSwapchain& swapchain,
+		PixelateRuntimePass& runtimePass,
+		VkPipeline pipeline,
+		uint64_t resourceGeneration)
+	{
+		auto& recordedCommandBuffer = GetRecordedCommandBuffer(device, frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass);
+		auto recordedStateHash = GetRecordedStateHash(runtimePass, swapchain.SwapchainImageViews[swapchainImageIndex], swapchain.Extent, resourceGeneration);
+
+		// Nothing the recording depends on has changed, replay it
+		if (recordedCommandBuffer.RecordedStateHash == recordedStateHash)
+			return recordedCommandBuffer.CommandBuffer;
+
+		recordedCommandBuffer.RecordedStateHash = recordedStateHash;
+		RecordGraphicsPass(recordedCommandBuffer.CommandBuffer, 0, passIndex, frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass, pipeline);
+
+		return recordedCommandBuffer.CommandBuffer;
+	}
+
+	// Compute passes touch neither attachments nor the swapchain image, until the pipeline is compiled only the barriers are recorded
+	static void RecordComputePass(
+		VkCommandBuffer commandBuffer,
+		VkCommandBufferUsageFlags usageFlags,
+		uint32_t passIndex,
+		uint32_t frameInFlightIndex,
+		PixelateRuntimePass& runtimePass,
+		VkPipeline pipeline)
+	{
+		VkCommandBufferBeginInfo commandBufferBeginInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = usageFlags,
+			.pInheritanceInfo = nullptr,
+		};
+		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+		GpuProfiler::BeginPass(commandBuffer, frameInFlightIndex, passIndex, runtimePass.Queue);
+
+		RenderGraphBarriers::Record(commandBuffer, runtimePass.BarriersBeforePass, VK_NULL_HANDLE);
+
+		if (pipeline != VK_NULL_HANDLE)
+		{
+			if (runtimePass.BindsDescriptorHeap)
+				BindlessDescriptors::Bind(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+			auto context = GetPassContext(commandBuffer, passIndex, frameInFlightIndex, runtimePass, pipeline);
+			runtimePass.CommandBufferCompute(context);
+		}
+
+		RenderGraphBarriers::Record(commandBuffer, runtimePass.BarriersAfterPass, VK_NULL_HANDLE);
+
+		GpuProfiler::EndPass(commandBuffer, frameInFlightIndex, passIndex, runtimePass.Queue);
 
-		vkCmdEndRendering(commandBuffer);
 		vkEndCommandBuffer(commandBuffer);
 	}
 
+	static VkCommandBuffer RecordComputePassOnce(
+		PixelateDevice device,
+		uint32_t passIndex,
+		uint32_t frameInFlightIndex,
+		uint32_t swapchainImageIndex,
+		const PixelateSwapchain& swapchain,
+		PixelateRuntimePass& runtimePass,
+		VkPipeline pipeline,
+		uint64_t resourceGeneration)
+	{
+		auto& recordedCommandBuffer = GetRecordedCommandBuffer(device, frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass);
+		auto recordedStateHash = GetRecordedStateHash(runtimePass, VK_NULL_HANDLE, {}, resourceGeneration);
+
+		if (recordedCommandBuffer.RecordedStateHash == recordedStateHash)
+			return recordedCommandBuffer.CommandBuffer;
+
+		recordedCommandBuffer.RecordedStateHash = recordedStateHash;
+		RecordComputePass(recordedCommandBuffer.CommandBuffer, 0, passIndex, frameInFlightIndex, runtimePass, pipeline);
+
+		return recordedCommandBuffer.CommandBuffer;
+	}
+
+	static VkCommandBuffer RecordGraphicsPassSlice(
+		PixelateDevice device,
+		uint32_t passIndex,
+		uint32_t frameInFlightIndex,
+		const PixelateRuntimePass& runtimePass,
+		VkPipeline pipeline,
+		uint32_t slice)
+	{
+		auto commandBuffer = CommandBufferManager::GetFrameCommandBuffer(
+			device,
+			frameInFlightIndex,
+			CommandBufferDescriptor
+			{
+				.Type = CommandBufferType::GraphicsQueue,
+				.Level = VkCommandBufferLevel::VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+				.PerformanceProfile = CommandBufferPerformanceProfile::Default,
+			});
+
+		VkCommandBufferInheritanceRenderingInfo commandBufferInheritanceRenderingInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.viewMask = 0,
+			.colorAttachmentCount = static_cast<uint32_t>(runtimePass.ColorAttachmentFormats.size()),
+			.pColorAttachmentFormats = runtimePass.ColorAttachmentFormats.data(),
+			.depthAttachmentFormat = runtimePass.DepthAttachmentFormat,
+			.stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+			.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+		};
+
+		VkCommandBufferInheritanceInfo commandBufferInheritanceInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+			.pNext = &commandBufferInheritanceRenderingInfo,
+			.renderPass = VK_NULL_HANDLE,
+			.subpass = 0,
+			.framebuffer = VK_NULL_HANDLE,
+			.occlusionQueryEnable = VK_FALSE,
+			.queryFlags = 0,
+			.pipelineStatistics = 0,
+		};
+
+		VkCommandBufferBeginInfo commandBufferBeginInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			.pInheritanceInfo = &commandBufferInheritanceInfo,
+		};
+		vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo);
+
+		Pipelines::SetDynamicState(commandBuffer, runtimePass.DynamicState, runtimePass.RenderingInfos[frameInFlightIndex].RenderingInfo.renderArea);
+		if (runtimePass.BindsDescriptorHeap)
+			BindlessDescriptors::Bind(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS); // secondary command buffers don't inherit bound sets
+
+		auto context = GetPassContext(commandBuffer, passIndex, frameInFlightIndex, runtimePass, pipeline);
+		context.SliceIndex = slice;
+		context.SliceCount = runtimePass.SliceCount;
+		runtimePass.CommandBufferGraphicsSlice(context);
+
+		vkEndCommandBuffer(commandBuffer);
+
+		return commandBuffer;
+	}
+
+	void RenderGraph::RunRecordingJob(
+		PixelateDevice device,
+		uint32_t frameInFlightIndex,
+		uint32_t swapchainImageIndex,
+		const PixelateSwapchain& swapchain,
+		const PassRecordingJob& job)
+	{
+		PXL8_PROFILE_SCOPE("RenderGraph::RecordPass");
+
+		auto& runtimePass = RuntimePasses[job.PassIndex];
+
+		if (job.Slice != WHOLE_PASS)
+		{
+			runtimePass.SliceCommandBuffers[job.Slice] = RecordGraphicsPassSlice(device, job.PassIndex, frameInFlightIndex, runtimePass, job.Pipeline, job.Slice);
+			return;
+		}
+
+		// Each thread allocates from its own command pools, so jobs never share a pool
+		auto commandBuffer = CommandBufferManager::GetFrameCommandBuffer(
+			device,
+			frameInFlightIndex,
+			CommandBufferDescriptor
+			{
+				.Type = GetCommandBufferType(runtimePass),
+				.Level = VkCommandBufferLevel::VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				.PerformanceProfile = CommandBufferPerformanceProfile::Default,
+			});
+
+		if (runtimePass.PassType == PassType::Compute)
+			RecordComputePass(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, job.PassIndex, frameInFlightIndex, runtimePass, job.Pipeline);
+		else
+			RecordGraphicsPass(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, job.PassIndex, frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass, job.Pipeline);
+
+		m_PassCommandBuffers[job.PassIndex] = commandBuffer;
+	}
+
+	// Every pass records its own barriers into its own command buffer, so the order of recording doesn't
+	// matter, only the order of submission. Passes recorded every frame and the slices of sliced passes
+	// are spread over the worker pool, record-once passes stay on this thread as their command buffers
+	// belong to its pools.
+	void RenderGraph::RecordPasses(PixelateDevice device, uint32_t frameInFlightIndex, uint32_t swapchainImageIndex, const PixelateSwapchain& swapchain)
+	{
+		m_PassCommandBuffers.assign(RuntimePasses.size(), VK_NULL_HANDLE);
+		m_RecordingJobs.clear();
+
+		for (uint32_t i = 0; i < RuntimePasses.size(); i++)
+		{
+			auto& runtimePass = RuntimePasses[i];
+
+			//TODO: implement other pass types
+			auto isRecorded = runtimePass.PassType == PassType::Graphics || runtimePass.PassType == PassType::Compute;
+			if (!isRecorded || (runtimePass.Flags & PIXELATE_PASS_RECORD_ONCE))
+				continue;
+
+			// Loaded once so all slices of a pass agree on whether the pipeline is ready
+			auto pipeline = runtimePass.Pipeline.Get();
+
+			if (runtimePass.CommandBufferGraphicsSlice == nullptr || pipeline == VK_NULL_HANDLE)
+			{
+				m_RecordingJobs.push_back(PassRecordingJob{ i, WHOLE_PASS, pipeline });
+				continue;
+			}
+
+			runtimePass.SliceCommandBuffers.assign(runtimePass.SliceCount, VK_NULL_HANDLE);
+			for (uint32_t slice = 0; slice < runtimePass.SliceCount; slice++)
+				m_RecordingJobs.push_back(PassRecordingJob{ i, slice, pipeline });
+		}
+
+		// Not worth the hand-off for a single job
+		std::optional<std::latch> jobsDone{};
+		if (m_RecordingJobs.size() > 1)
+		{
+			jobsDone.emplace(static_cast<ptrdiff_t>(m_RecordingJobs.size()));
+
+			for (const auto& job : m_RecordingJobs)
+			{
+				GetPassRecordingPool().Submit([this, device, frameInFlightIndex, swapchainImageIndex, &swapchain, job, &jobsDone]()
+					{
+						RunRecordingJob(device, frameInFlightIndex, swapchainImageIndex, swapchain, job);
+						jobsDone->count_down();
+					});
+			}
+		}
+		else
+		{
+			for (const auto& job : m_RecordingJobs)
+				RunRecordingJob(device, frameInFlightIndex, swapchainImageIndex, swapchain, job);
+		}
+
+		// Overlaps with the workers, usually only a hash check
+		for (uint32_t i = 0; i < RuntimePasses.size(); i++)
+		{
+			auto& runtimePass = RuntimePasses[i];
+
+			if (!(runtimePass.Flags & PIXELATE_PASS_RECORD_ONCE))
+				continue;
+
+			if (runtimePass.PassType == PassType::Graphics)
+				m_PassCommandBuffers[i] = RecordGraphicsPassOnce(device, i, frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass, runtimePass.Pipeline.Get(), m_ResourceGeneration);
+			else if (runtimePass.PassType == PassType::Compute)
+				m_PassCommandBuffers[i] = RecordComputePassOnce(device, i, frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass, runtimePass.Pipeline.Get(), m_ResourceGeneration);
+		}
+
+		if (jobsDone.has_value())
+			jobsDone->wait();
+
+		// Primaries of sliced passes only execute their slices, recorded here so no job ever waits on another
+		for (uint32_t i = 0; i < RuntimePasses.size(); i++)
+		{
+			auto& runtimePass = RuntimePasses[i];
+
+			if (runtimePass.PassType != PassType::Graphics || m_PassCommandBuffers[i] != VK_NULL_HANDLE || runtimePass.SliceCommandBuffers.empty())
+				continue;
+
+			auto commandBuffer = CommandBufferManager::GetFrameCommandBuffer(device, frameInFlightIndex);
+			RecordGraphicsPass(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, i, frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass, VK_NULL_HANDLE, runtimePass.SliceCommandBuffers);
+			m_PassCommandBuffers[i] = commandBuffer;
+
+			runtimePass.SliceCommandBuffers.clear();
+		}
+	}
+
+	void RenderGraph::DisposeRecordingWorkers()
+	{
+		if (g_PassRecordingPool)
+			g_PassRecordingPool->Dispose();
+
+		g_PassRecordingPool.reset();
+	}
+
+	static void LogGpuPassTimings(const std::vector<GpuPassTiming>& timings, uint32_t frameCount)
+	{
+		PXL8_CORE_INFO("GPU pass timings over " + std::to_string(frameCount) + " frames (min/avg/max ms):");
+
+		for (const auto& timing : timings)
+		{
+			if (timing.SampleCount == 0)
+				continue;
+
+			PXL8_CORE_INFO(std::string("    ") + timing.PassName + ": "
+				+ std::to_string(timing.TimeMin) + "/" + std::to_string(timing.AverageTime()) + "/" + std::to_string(timing.TimeMax));
+		}
+	}
+
+	// The frame pacer has waited for this slot's previous frame, so its queries are complete
+	void RenderGraph::CollectGpuPassTimings(uint32_t frameInFlightIndex)
+	{
+		auto passCount = m_TimedPassCounts[frameInFlightIndex];
+		m_TimedPassCounts[frameInFlightIndex] = GpuProfiler::IsEnabled() ? std::min<uint32_t>(RuntimePasses.size(), GpuProfiler::MAX_TIMED_PASSES) : 0;
+
+		if (passCount == 0)
+			return;
+
+		GpuProfiler::ReadPassTimes(frameInFlightIndex, passCount, m_GpuPassTimes);
+
+		for (uint32_t i = 0; i < passCount; i++)
+		{
+			auto time = m_GpuPassTimes[i];
+			if (time < 0.0)
+				continue;
+
+			auto& timing = m_GpuPassTimings[i];
+			timing.LastTime = time;
+			timing.TimeMin = std::min(timing.TimeMin, time);
+			timing.TimeMax = std::max(timing.TimeMax, time);
+			timing.TimeSum += time;
+			timing.SampleCount++;
+		}
+
+		if (++m_TimedFrameCount < PixelateSettings::FRAME_STATISTICS_LOG_INTERVAL)
+			return;
+
+		LogGpuPassTimings(m_GpuPassTimings, m_TimedFrameCount);
+		m_TimedFrameCount = 0;
+
+		for (auto& timing : m_GpuPassTimings)
+			timing = GpuPassTiming{ .PassName = timing.PassName, .LastTime = timing.LastTime };
+	}
+
 	// TODO: add return values:
-	// fences in order
 	// semaphores in order
-	// last swapchain image layout
-	std::tuple<FenceGroup, PixelateSemaphore> RenderGraph::RecordAndSubmit(
+	PixelateSemaphore RenderGraph::RecordAndSubmit(
 		PixelateDevice device,
 		uint32_t frameInFlightIndex,
 		uint32_t swapchainImageIndex,
 		VkSemaphoreSubmitInfo* pWaitSemaphores,
 		uint32_t waitSemaphoreCount,
-		const PixelateSwapchain& swapchain)
+		const PixelateSwapchain& swapchain,
+		TimelinePoint frameComplete)
 	{
-		auto queueSubmitFences = FenceManager::GetFenceGroup(
-			device.VkDevice,
-			FenceGroupDescriptor
-			{
-				.Identifier = FenceIdenfitier::RenderGraphQueueSubmit,
-				.FenceGroupSize = static_cast<uint32_t>(RuntimePasses.size())
-			});
+		PXL8_PROFILE_SCOPE("RenderGraph::RecordAndSubmit");
+
+		if (!m_PipelinesReady && ArePipelinesReady())
+		{
+			m_PipelinesReady = true;
+			auto readyTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_BuildStart).count();
+			PXL8_CORE_INFO("All render graph pipelines ready " + std::to_string(readyTime) + " ms after the graph was built.");
+		}
 
+		// The transition to present is the last thing touching the image, it is synchronized on color attachment output.
+		// Indexed by swapchain image, the presentation engine may still hold the semaphore of the previous frame in this slot
 		auto swapchainImageReadyToPresentSemaphore = SemaphoreManager::GetSemaphore(
 			device.VkDevice,
-			VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
 			SemaphoreDescriptor{
 				SemaphoreIdentifier::SwapchainImageReadyToPresent,
-				frameInFlightIndex,
+				swapchainImageIndex,
 			});
 
-		// Find the last operation in the render graph that outputs a swapchain image
-		int lastSwapchainOperationIndex = 0;
-		for (int i = 0; i < RuntimePasses.size(); i++)
-			if (RuntimePasses[i].Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN)
-				lastSwapchainOperationIndex = i;
+		CollectGpuPassTimings(frameInFlightIndex);
 
-		for (int i = 0; i < RuntimePasses.size(); i++)
+		auto recordingStart = std::chrono::steady_clock::now();
+
+		RecordPasses(device, frameInFlightIndex, swapchainImageIndex, swapchain);
+
+		m_RecordingTimeSum += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordingStart).count();
+		if (++m_RecordedFrameCount >= PixelateSettings::FRAME_STATISTICS_LOG_INTERVAL)
 		{
-			auto& runtimePass = RuntimePasses[i];
+			auto threadCount = g_PassRecordingPool ? g_PassRecordingPool->GetThreadCount() : 0;
+			PXL8_CORE_INFO("Render graph recording: " + std::to_string(m_RecordingTimeSum / m_RecordedFrameCount) + " ms average over "
+				+ std::to_string(m_RecordedFrameCount) + " frames, " + std::to_string(RuntimePasses.size()) + " passes, "
+				+ std::to_string(threadCount) + " worker threads.");
+			m_RecordingTimeSum = 0.0;
+			m_RecordedFrameCount = 0;
+		}
+
+		auto& batches = m_Schedule.Batches;
 
-			auto signalSemaphore = lastSwapchainOperationIndex == i ? &swapchainImageReadyToPresentSemaphore.SemaphoreSubmitInfo : nullptr;
-			uint32_t signalSemaphoreCount = lastSwapchainOperationIndex == i;
+		// Compute batches signal points on the compute timeline. The graphics point of the frame is already reserved for its end,
+		// so graphics batches the compute queue waits on signal binary semaphores, one per batch and frame in flight.
+		m_BatchSignals.assign(batches.size(), VkSemaphoreSubmitInfo{});
+		for (uint32_t i = 0; i < batches.size(); i++)
+		{
+			if (!batches[i].IsWaitedOn)
+				continue;
+
+			if (batches[i].Queue == TimelineQueue::Compute)
+				m_BatchSignals[i] = TimelineManager::GetSubmitInfo(TimelineManager::Reserve(TimelineQueue::Compute), VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+			else
+				m_BatchSignals[i] = SemaphoreManager::GetSemaphore(
+					device.VkDevice,
+					VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+					SemaphoreDescriptor{
+						SemaphoreIdentifier::GraphicsToComputeHandoff,
+						frameInFlightIndex + PixelateSettings::MAX_FRAMES_IN_FLIGHT * i,
+					}).SemaphoreSubmitInfo;
+		}
 
-			switch (runtimePass.PassType)
+		// Batch indices are signed like PixelateSubmissionBatch::WaitBatch, -1 for none
+		auto batchCount = static_cast<int32_t>(batches.size());
+
+		int32_t lastGraphicsBatch = -1;
+		int32_t firstComputeBatch = -1;
+		for (int32_t i = 0; i < batchCount; i++)
+		{
+			if (batches[i].Queue == TimelineQueue::Graphics)
+				lastGraphicsBatch = i;
+			else if (firstComputeBatch < 0)
+				firstComputeBatch = i;
+		}
+
+		// The submit infos point into these, reserved up front so they never reallocate while being filled
+		m_CommandBufferSubmitInfos.clear();
+		m_CommandBufferSubmitInfos.reserve(RuntimePasses.size());
+		m_SemaphoreSubmitInfos.clear();
+		m_SemaphoreSubmitInfos.reserve(batches.size() * (waitSemaphoreCount + 4));
+		m_SubmitInfos.resize(batches.size());
+
+		for (int32_t i = 0; i < batchCount; i++)
+		{
+			auto& batch = batches[i];
+
+			auto commandBufferStart = m_CommandBufferSubmitInfos.size();
+			for (auto pass : batch.Passes)
 			{
-			case PassType::Graphics:
-				RecordGraphicsPass(frameInFlightIndex, swapchainImageIndex, swapchain, runtimePass); // TODO: Check if the pass is flagged with "record-once", and statetrack that shit
-
-				QueueManager::GraphicsQueueSubmit(
-					device,
-					GraphicsQueueSubmitDescriptor(),
-					runtimePass.CommandBuffer[frameInFlightIndex],
-					queueSubmitFences[i],
-					signalSemaphore, signalSemaphoreCount,
-					pWaitSemaphores, waitSemaphoreCount);
-				
-				break;
-				//TODO: implement other pass types
+				if (m_PassCommandBuffers[pass] == VK_NULL_HANDLE)
+					continue;
+
+				m_CommandBufferSubmitInfos.push_back(VkCommandBufferSubmitInfo
+					{
+						.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+						.commandBuffer = m_PassCommandBuffers[pass],
+						.deviceMask = 0b1,
+					});
+			}
+
+			auto waitStart = m_SemaphoreSubmitInfos.size();
+			if (batch.WaitsForSwapchainImage)
+				m_SemaphoreSubmitInfos.insert(m_SemaphoreSubmitInfos.end(), pWaitSemaphores, pWaitSemaphores + waitSemaphoreCount);
+
+			// The compute queue may otherwise touch resources the previous frame's graphics work still uses
+			if (i == firstComputeBatch && m_LastFrameComplete.Value > 0)
+				m_SemaphoreSubmitInfos.push_back(TimelineManager::GetSubmitInfo(m_LastFrameComplete, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT));
+
+			if (batch.WaitBatch >= 0)
+				m_SemaphoreSubmitInfos.push_back(m_BatchSignals[batch.WaitBatch]);
+
+			auto signalStart = m_SemaphoreSubmitInfos.size();
+			if (batch.IsWaitedOn)
+				m_SemaphoreSubmitInfos.push_back(m_BatchSignals[i]);
+
+			// The binary semaphore is for the presentation engine, the timeline value tracks completion of the whole frame
+			if (i == lastGraphicsBatch)
+			{
+				m_SemaphoreSubmitInfos.push_back(swapchainImageReadyToPresentSemaphore.SemaphoreSubmitInfo);
+				m_SemaphoreSubmitInfos.push_back(TimelineManager::GetSubmitInfo(frameComplete, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT));
 			}
+
+			m_SubmitInfos[i] = VkSubmitInfo2
+			{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+				.waitSemaphoreInfoCount = static_cast<uint32_t>(signalStart - waitStart),
+				.pWaitSemaphoreInfos = m_SemaphoreSubmitInfos.data() + waitStart,
+				.commandBufferInfoCount = static_cast<uint32_t>(m_CommandBufferSubmitInfos.size() - commandBufferStart),
+				.pCommandBufferInfos = m_CommandBufferSubmitInfos.data() + commandBufferStart,
+				.signalSemaphoreInfoCount = static_cast<uint32_t>(m_SemaphoreSubmitInfos.size() - signalStart),
+				.pSignalSemaphoreInfos = m_SemaphoreSubmitInfos.data() + signalStart,
+			};
 		}
 
-		return std::make_tuple(queueSubmitFences, swapchainImageReadyToPresentSemaphore);
+		// Consecutive batches of one queue go in a single vkQueueSubmit2, batches only wait on earlier submissions
+		for (uint32_t first = 0; first < batches.size();)
+		{
+			auto last = first + 1;
+			while (last < batches.size() && batches[last].Queue == batches[first].Queue)
+				last++;
+
+			if (batches[first].Queue == TimelineQueue::Compute)
+				QueueManager::ComputeQueueSubmit(device, ComputeQueueSubmitDescriptor(), m_SubmitInfos.data() + first, last - first, VK_NULL_HANDLE);
+			else
+				QueueManager::GraphicsQueueSubmit(device, GraphicsQueueSubmitDescriptor(), m_SubmitInfos.data() + first, last - first, VK_NULL_HANDLE);
+
+			first = last;
+		}
+
+		m_LastFrameComplete = frameComplete;
+
+		return swapchainImageReadyToPresentSemaphore;
 	}
 }
 
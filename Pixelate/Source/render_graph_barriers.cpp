@@ -0,0 +1,490 @@
+#include <set>
+#include <string>
+#include "render_graph_barriers.h"
+#include "log.h"
+
+namespace Pixelate::RenderGraphBarriers
+{
+	static constexpr VkAccessFlags2 WriteAccessMask =
+		VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+		| VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+		| VK_ACCESS_2_TRANSFER_WRITE_BIT
+		| VK_ACCESS_2_HOST_WRITE_BIT
+		| VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+	// Where a resource stands after the passes walked so far
+	struct TrackedResource
+	{
+		bool IsImage = true;
+		bool IsSwapchainImage = false;
+		bool IsFirstAccessWrite = false; // contents from the previous frame are never read and can be discarded
+		VkImageAspectFlags AspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		VkImageLayout Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags2 WriteStages = VK_PIPELINE_STAGE_2_NONE; // last write, or layout transition
+		VkAccessFlags2 WriteAccess = VK_ACCESS_2_NONE;
+		VkPipelineStageFlags2 ReadStages = VK_PIPELINE_STAGE_2_NONE; // reads since the last write, the next write must wait for them
+		VkPipelineStageFlags2 VisibleStages = VK_PIPELINE_STAGE_2_NONE; // stages the last write has already been made visible to
+		uint32_t QueueFamily = VK_QUEUE_FAMILY_IGNORED; // owner of the exclusive resource, ignored until a pass records with it
+		size_t LastAccessPass = 0; // last recording pass using it, where a release to another family goes
+		bool IsDiscardable = false; // contents left by the previous frame are never read
+	};
+
+	static VkPipelineStageFlags2 GetShaderStages(const PixelateResourceUsage& usage, VkPipelineStageFlags2 defaultStages)
+	{
+		return usage.StageFlags != 0 ? static_cast<VkPipelineStageFlags2>(usage.StageFlags) : defaultStages;
+	}
+
+	static PixelateResourceState GetResourceState(const PixelateResourceUsage& usage, bool isOutput, PassType passType)
+	{
+		PixelateResourceState state{};
+		auto isCompute = passType == PassType::Compute;
+
+		if (usage.UsageFlags & PIXELATE_USAGE_COLOR_ATTACMENT)
+		{
+			state.StageMask |= VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+			state.AccessMask |= isOutput ? VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT;
+			if (isOutput && usage.BlendState.blendEnable)
+				state.AccessMask |= VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT;
+			state.Layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		}
+
+		if (usage.UsageFlags & PIXELATE_USAGE_DEPTH_ATTACMENT)
+		{
+			state.StageMask |= VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+			state.AccessMask |= isOutput
+				? VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+				: VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+			state.Layout = isOutput ? VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL;
+			state.AspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		}
+
+		if (usage.UsageFlags & PIXELATE_USAGE_SAMPLED_TEXTURE_BUFFER)
+		{
+			state.StageMask |= GetShaderStages(usage, isCompute ? VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+			state.AccessMask |= VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+			state.Layout = state.Layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+		}
+
+		if (usage.UsageFlags & PIXELATE_USAGE_STORAGE_BUFFER)
+		{
+			state.StageMask |= GetShaderStages(usage, isCompute ? VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+			state.AccessMask |= isOutput
+				? VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT
+				: VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+			state.Layout = VK_IMAGE_LAYOUT_GENERAL;
+		}
+
+		if (usage.UsageFlags & PIXELATE_USAGE_VERTEX_BUFFER)
+		{
+			state.StageMask |= VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+			state.AccessMask |= VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
+		}
+
+		if (usage.UsageFlags & PIXELATE_USAGE_INDEX_BUFFER)
+		{
+			state.StageMask |= VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT;
+			state.AccessMask |= VK_ACCESS_2_INDEX_READ_BIT;
+		}
+
+		return state;
+	}
+
+	struct PassAccess
+	{
+		PixelateResourceState State;
+		const PixelateResourceUsage* pUsage;
+		bool IsInput; // the pass reads what earlier passes, or the previous frame, left in the resource
+	};
+
+	// Inputs and outputs naming the same resource in one pass collapse into a single access
+	static std::map<std::string, PassAccess> GetPassAccesses(const PixelatePass& pass)
+	{
+		std::map<std::string, PassAccess> accesses{};
+
+		auto addAccess = [&](const PixelateResourceUsage& usage, bool isOutput)
+		{
+			auto state = GetResourceState(usage, isOutput, pass.PassType);
+			auto [access, inserted] = accesses.try_emplace(usage.Resource.Name, PassAccess{ state, &usage, !isOutput });
+
+			if (inserted)
+				return;
+
+			auto& merged = access->second.State;
+			if (merged.Layout != state.Layout)
+			{
+				PXL8_CORE_WARN(std::string("Resource \"") + usage.Resource.Name + "\" is used with conflicting layouts in pass \"" + pass.Name + "\", falling back to the general layout.");
+				merged.Layout = VK_IMAGE_LAYOUT_GENERAL;
+			}
+			merged.StageMask |= state.StageMask;
+			merged.AccessMask |= state.AccessMask;
+			access->second.IsInput |= !isOutput;
+		};
+
+		for (const auto& usage : pass.Inputs)
+			addAccess(usage, false);
+		for (const auto& usage : pass.Outputs)
+			addAccess(usage, true);
+
+		return accesses;
+	}
+
+	static void AddBarrier(
+		PixelatePassBarriers& barriers,
+		const char* resourceName,
+		const TrackedResource& resource,
+		VkPipelineStageFlags2 srcStageMask,
+		VkAccessFlags2 srcAccessMask,
+		const PixelateResourceState& next)
+	{
+		if (!resource.IsImage)
+		{
+			barriers.MemoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+			barriers.MemoryBarrier.srcStageMask |= srcStageMask;
+			barriers.MemoryBarrier.srcAccessMask |= srcAccessMask;
+			barriers.MemoryBarrier.dstStageMask |= next.StageMask;
+			barriers.MemoryBarrier.dstAccessMask |= next.AccessMask;
+			return;
+		}
+
+		barriers.ImageBarriers.push_back(VkImageMemoryBarrier2
+			{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+				.srcStageMask = srcStageMask,
+				.srcAccessMask = srcAccessMask,
+				.dstStageMask = next.StageMask,
+				.dstAccessMask = next.AccessMask,
+				.oldLayout = resource.Layout,
+				.newLayout = next.Layout,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = VK_NULL_HANDLE,
+				.subresourceRange = { resource.AspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS },
+			});
+		barriers.ImageBarrierResources.push_back(resource.IsSwapchainImage ? nullptr : resourceName);
+	}
+
+	// Moves the resource to its next state, emitting a barrier only for a real hazard or layout change
+	static void Transition(PixelatePassBarriers& barriers, const char* resourceName, TrackedResource& resource, const PixelateResourceState& next)
+	{
+		auto isWrite = (next.AccessMask & WriteAccessMask) != 0;
+		auto isLayoutChange = resource.IsImage && resource.Layout != next.Layout;
+
+		if (isWrite || isLayoutChange)
+		{
+			// Write-after-write and write-after-read, reads only need an execution dependency
+			auto srcStageMask = resource.WriteStages | resource.ReadStages;
+			if (srcStageMask != VK_PIPELINE_STAGE_2_NONE || isLayoutChange)
+				AddBarrier(barriers, resourceName, resource, srcStageMask, resource.WriteAccess, next);
+
+			resource.Layout = next.Layout;
+			resource.WriteStages = next.StageMask;
+			resource.WriteAccess = next.AccessMask & (isWrite ? WriteAccessMask : VK_ACCESS_2_NONE);
+			resource.ReadStages = isWrite ? VK_PIPELINE_STAGE_2_NONE : next.StageMask;
+			resource.VisibleStages = next.StageMask;
+			return;
+		}
+
+		// Read-after-write, unless an earlier barrier already made the write visible to these stages
+		auto unsynchronizedStages = next.StageMask & ~resource.VisibleStages;
+		if (resource.WriteStages != VK_PIPELINE_STAGE_2_NONE && unsynchronizedStages != VK_PIPELINE_STAGE_2_NONE)
+		{
+			AddBarrier(barriers, resourceName, resource, resource.WriteStages, resource.WriteAccess, next);
+			resource.VisibleStages |= next.StageMask;
+		}
+
+		resource.ReadStages |= next.StageMask;
+	}
+
+	static void AddOwnershipBarrier(
+		PixelatePassBarriers& barriers,
+		const char* resourceName,
+		const TrackedResource& resource,
+		VkPipelineStageFlags2 srcStageMask,
+		VkAccessFlags2 srcAccessMask,
+		VkPipelineStageFlags2 dstStageMask,
+		VkAccessFlags2 dstAccessMask,
+		VkImageLayout newLayout,
+		uint32_t srcQueueFamily,
+		uint32_t dstQueueFamily)
+	{
+		if (!resource.IsImage)
+		{
+			barriers.BufferBarriers.push_back(VkBufferMemoryBarrier2
+				{
+					.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+					.srcStageMask = srcStageMask,
+					.srcAccessMask = srcAccessMask,
+					.dstStageMask = dstStageMask,
+					.dstAccessMask = dstAccessMask,
+					.srcQueueFamilyIndex = srcQueueFamily,
+					.dstQueueFamilyIndex = dstQueueFamily,
+					.buffer = VK_NULL_HANDLE,
+					.offset = 0,
+					.size = VK_WHOLE_SIZE,
+				});
+			barriers.BufferBarrierResources.push_back(resourceName);
+			return;
+		}
+
+		barriers.ImageBarriers.push_back(VkImageMemoryBarrier2
+			{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+				.srcStageMask = srcStageMask,
+				.srcAccessMask = srcAccessMask,
+				.dstStageMask = dstStageMask,
+				.dstAccessMask = dstAccessMask,
+				.oldLayout = resource.Layout,
+				.newLayout = newLayout,
+				.srcQueueFamilyIndex = srcQueueFamily,
+				.dstQueueFamilyIndex = dstQueueFamily,
+				.image = VK_NULL_HANDLE,
+				.subresourceRange = { resource.AspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS },
+			});
+		barriers.ImageBarrierResources.push_back(resourceName);
+	}
+
+	// Moves the resource to another queue family. The release goes after its last use on the old family and the acquire
+	// before this pass, both with the same layouts. The semaphore between the queues orders them, so neither side names
+	// stages of the other queue. Contents nobody reads are left behind, only the layout is set on the new queue.
+	static void TransferOwnership(
+		PixelateGraphBarriers* pBarriers,
+		size_t passIndex,
+		const char* resourceName,
+		TrackedResource& resource,
+		uint32_t queueFamily,
+		const PixelateResourceState& next)
+	{
+		if (pBarriers != nullptr && !resource.IsDiscardable)
+		{
+			AddOwnershipBarrier(
+				pBarriers->AfterPass[resource.LastAccessPass], resourceName, resource,
+				resource.WriteStages | resource.ReadStages, resource.WriteAccess,
+				VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+				next.Layout, resource.QueueFamily, queueFamily);
+			AddOwnershipBarrier(
+				pBarriers->BeforePass[passIndex], resourceName, resource,
+				VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+				next.StageMask, next.AccessMask,
+				next.Layout, resource.QueueFamily, queueFamily);
+		}
+		else if (pBarriers != nullptr && resource.IsImage)
+		{
+			AddOwnershipBarrier(
+				pBarriers->BeforePass[passIndex], resourceName, resource,
+				VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+				next.StageMask, next.AccessMask,
+				next.Layout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+		}
+
+		// Like a layout transition, later barriers on this queue chain to the acquire
+		auto isWrite = (next.AccessMask & WriteAccessMask) != 0;
+		resource.Layout = next.Layout;
+		resource.WriteStages = next.StageMask;
+		resource.WriteAccess = next.AccessMask & (isWrite ? WriteAccessMask : VK_ACCESS_2_NONE);
+		resource.ReadStages = isWrite ? VK_PIPELINE_STAGE_2_NONE : next.StageMask;
+		resource.VisibleStages = next.StageMask;
+	}
+
+	static TrackedResource GetInitialState(bool isImage, VkImageAspectFlags aspectMask, bool isSwapchainImage)
+	{
+		TrackedResource resource{};
+		resource.IsImage = isImage;
+		resource.IsSwapchainImage = isSwapchainImage;
+		resource.AspectMask = aspectMask;
+
+		// The image acquire semaphore is waited on at the color attachment output stage, chain the first transition to it
+		if (isSwapchainImage)
+			resource.WriteStages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		return resource;
+	}
+
+	static void WalkPasses(
+		const std::vector<PixelatePass>& passes,
+		std::map<std::string, TrackedResource>& resources,
+		const std::map<std::string, std::string>& aliasPredecessors,
+		const std::vector<uint32_t>& passQueueFamilies,
+		PixelateGraphBarriers* pBarriers)
+	{
+		std::set<std::string> accessedResources{};
+
+		for (size_t i = 0; i < passes.size(); i++)
+		{
+			// Host passes record nothing, a release can't go into them
+			auto recordsCommands = passes[i].PassType == PassType::Graphics || passes[i].PassType == PassType::Compute;
+			auto queueFamily = passQueueFamilies.empty() ? VK_QUEUE_FAMILY_IGNORED : passQueueFamilies[i];
+
+			for (const auto& [name, access] : GetPassAccesses(passes[i]))
+			{
+				const auto& [state, pUsage, isInput] = access;
+				auto isSwapchainImage = (passes[i].Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN) && (pUsage->UsageFlags & PIXELATE_USAGE_COLOR_ATTACMENT);
+
+				auto [resource, inserted] = resources.try_emplace(
+					name,
+					GetInitialState(pUsage->Resource.Type == PixelateResourceType::Image, state.AspectMask, isSwapchainImage));
+				resource->second.IsSwapchainImage |= isSwapchainImage;
+
+				// Attachments are always cleared, so a first use that only writes discards the previous contents
+				if (inserted)
+					resource->second.IsFirstAccessWrite = !isInput && (state.AccessMask & WriteAccessMask) != 0;
+
+				// Taking over aliased memory, wait for whatever the previous occupant did with it
+				auto predecessor = aliasPredecessors.find(name);
+				if (accessedResources.insert(name).second && predecessor != aliasPredecessors.end())
+				{
+					auto previousOccupant = resources.find(predecessor->second);
+					if (previousOccupant != resources.end())
+					{
+						resource->second.ReadStages |= previousOccupant->second.WriteStages | previousOccupant->second.ReadStages;
+						resource->second.WriteAccess |= previousOccupant->second.WriteAccess;
+					}
+				}
+
+				auto& tracked = resource->second;
+				auto changesQueueFamily = recordsCommands
+					&& !tracked.IsSwapchainImage
+					&& tracked.QueueFamily != VK_QUEUE_FAMILY_IGNORED
+					&& tracked.QueueFamily != queueFamily;
+
+				if (changesQueueFamily)
+					TransferOwnership(pBarriers, i, pUsage->Resource.Name, tracked, queueFamily, state);
+				else
+				{
+					PixelatePassBarriers discardedBarriers{};
+					Transition(pBarriers ? pBarriers->BeforePass[i] : discardedBarriers, pUsage->Resource.Name, tracked, state);
+				}
+
+				tracked.IsDiscardable = false;
+
+				if (recordsCommands)
+				{
+					tracked.QueueFamily = queueFamily;
+					tracked.LastAccessPass = i;
+				}
+			}
+		}
+	}
+
+	PixelateGraphBarriers Synthesize(
+		const std::vector<PixelatePass>& passes,
+		const std::map<std::string, std::string>& aliasPredecessors,
+		const std::vector<uint32_t>& passQueueFamilies)
+	{
+		PixelateGraphBarriers barriers{};
+		barriers.BeforePass.resize(passes.size());
+		barriers.AfterPass.resize(passes.size());
+
+		// First walk finds the state every resource is left in at the end of a frame,
+		// which is the state the next frame finds it in
+		std::map<std::string, TrackedResource> resources{};
+		WalkPasses(passes, resources, {}, passQueueFamilies, nullptr);
+
+		for (auto& [name, resource] : resources)
+		{
+			if (resource.IsSwapchainImage)
+			{
+				// Acquired images come back in an undefined layout every frame
+				resource = GetInitialState(true, resource.AspectMask, true);
+				continue;
+			}
+
+			if (resource.IsImage && resource.IsFirstAccessWrite)
+				resource.Layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			resource.IsDiscardable = resource.IsFirstAccessWrite;
+
+			// Reads of last frame's contents see everything, writes wait for last frame's reads and writes
+			resource.ReadStages |= resource.WriteStages;
+			resource.VisibleStages = VK_PIPELINE_STAGE_2_NONE;
+		}
+
+		WalkPasses(passes, resources, aliasPredecessors, passQueueFamilies, &barriers);
+
+		// Fold the transition to present into the last pass writing the swapchain image
+		for (size_t i = passes.size(); i-- > 0;)
+		{
+			if (!(passes[i].Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN))
+				continue;
+
+			for (auto& [name, resource] : resources)
+			{
+				if (!resource.IsSwapchainImage)
+					continue;
+
+				// Only the presentation engine reads the image after this, the ready to present semaphore carries the dependency
+				AddBarrier(
+					barriers.AfterPass[i],
+					name.c_str(),
+					resource,
+					resource.WriteStages | resource.ReadStages,
+					resource.WriteAccess,
+					PixelateResourceState
+					{
+						.StageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+						.AccessMask = VK_ACCESS_2_NONE,
+						.Layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+					});
+			}
+			break;
+		}
+
+		size_t imageBarrierCount = 0;
+		size_t bufferBarrierCount = 0;
+		size_t memoryBarrierCount = 0;
+		for (size_t i = 0; i < passes.size(); i++)
+		{
+			imageBarrierCount += barriers.BeforePass[i].ImageBarriers.size() + barriers.AfterPass[i].ImageBarriers.size();
+			bufferBarrierCount += barriers.BeforePass[i].BufferBarriers.size() + barriers.AfterPass[i].BufferBarriers.size();
+			memoryBarrierCount += barriers.BeforePass[i].HasMemoryBarrier() + barriers.AfterPass[i].HasMemoryBarrier();
+		}
+
+		PXL8_CORE_TRACE("Render graph synchronization: " + std::to_string(imageBarrierCount) + " image barriers, "
+			+ std::to_string(bufferBarrierCount) + " buffer ownership transfers and "
+			+ std::to_string(memoryBarrierCount) + " memory barriers across " + std::to_string(passes.size()) + " passes.");
+
+		return barriers;
+	}
+
+	void Record(VkCommandBuffer commandBuffer, PixelatePassBarriers& barriers, VkImage swapchainImage)
+	{
+		if (barriers.IsEmpty())
+			return;
+
+		auto allImagesResolved = true;
+		for (size_t i = 0; i < barriers.ImageBarriers.size(); i++)
+		{
+			if (barriers.ImageBarrierResources[i] == nullptr)
+				barriers.ImageBarriers[i].image = swapchainImage;
+
+			allImagesResolved &= barriers.ImageBarriers[i].image != VK_NULL_HANDLE;
+		}
+
+		// Resources without physical memory behind them yet have nothing to synchronize
+		std::vector<VkImageMemoryBarrier2> resolvedImageBarriers{};
+		if (!allImagesResolved)
+		{
+			for (const auto& imageBarrier : barriers.ImageBarriers)
+				if (imageBarrier.image != VK_NULL_HANDLE)
+					resolvedImageBarriers.push_back(imageBarrier);
+		}
+
+		auto pImageBarriers = allImagesResolved ? barriers.ImageBarriers.data() : resolvedImageBarriers.data();
+		auto imageBarrierCount = allImagesResolved ? barriers.ImageBarriers.size() : resolvedImageBarriers.size();
+
+		if (imageBarrierCount == 0 && barriers.BufferBarriers.empty() && !barriers.HasMemoryBarrier())
+			return;
+
+		VkDependencyInfo dependencyInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.memoryBarrierCount = barriers.HasMemoryBarrier() ? 1u : 0u,
+			.pMemoryBarriers = &barriers.MemoryBarrier,
+			.bufferMemoryBarrierCount = static_cast<uint32_t>(barriers.BufferBarriers.size()),
+			.pBufferMemoryBarriers = barriers.BufferBarriers.data(),
+			.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarrierCount),
+			.pImageMemoryBarriers = pImageBarriers,
+		};
+
+		vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+	}
+}
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <map>
+#include <string>
+#include "render_graph_scheduler.h"
+#include "log.h"
+
+namespace Pixelate::RenderGraphScheduler
+{
+	static constexpr uint32_t s_QueueCount = 2; // graphics, compute
+
+	static uint32_t GetQueueIndex(TimelineQueue queue)
+	{
+		return queue == TimelineQueue::Compute ? 1 : 0;
+	}
+
+	// Resource names each pass touches, the swapchain image is left out as it never leaves the graphics queue
+	static std::vector<std::vector<std::string>> GetPassResources(const std::vector<PixelatePass>& passes)
+	{
+		std::vector<std::vector<std::string>> passResources(passes.size());
+
+		for (size_t i = 0; i < passes.size(); i++)
+		{
+			for (const auto* usages : { &passes[i].Inputs, &passes[i].Outputs })
+			{
+				for (const auto& usage : *usages)
+				{
+					if ((passes[i].Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN) && (usage.UsageFlags & PIXELATE_USAGE_COLOR_ATTACMENT))
+						continue;
+
+					passResources[i].push_back(usage.Resource.Name);
+				}
+			}
+		}
+
+		return passResources;
+	}
+
+	// dependencies[i][j], j < i, is true if pass i depends on pass j directly or through other passes.
+	// Every pass sharing a resource depends on its previous user, reads included, as it may have to change queue family.
+	static std::vector<std::vector<bool>> GetDependencies(const std::vector<std::vector<std::string>>& passResources)
+	{
+		auto passCount = passResources.size();
+		std::vector<std::vector<bool>> dependencies(passCount, std::vector<bool>(passCount, false));
+		std::map<std::string, uint32_t> lastAccess{};
+
+		for (uint32_t i = 0; i < passCount; i++)
+		{
+			for (const auto& name : passResources[i])
+			{
+				auto previous = lastAccess.find(name);
+				if (previous != lastAccess.end() && previous->second != i)
+				{
+					auto j = previous->second;
+					dependencies[i][j] = true;
+
+					for (uint32_t k = 0; k < j; k++)
+						if (dependencies[j][k])
+							dependencies[i][k] = true;
+				}
+
+				lastAccess[name] = i;
+			}
+		}
+
+		return dependencies;
+	}
+
+	// A compute pass only gains from the async queue if there is graphics work it can run next to
+	static bool HasIndependentGraphicsPass(const std::vector<PixelatePass>& passes, const std::vector<std::vector<bool>>& dependencies, uint32_t computePass)
+	{
+		for (uint32_t i = 0; i < passes.size(); i++)
+		{
+			if (passes[i].PassType != PassType::Graphics)
+				continue;
+
+			auto isDependent = i < computePass ? dependencies[computePass][i] : dependencies[i][computePass];
+			if (!isDependent)
+				return true;
+		}
+
+		return false;
+	}
+
+	struct BatchBuilder
+	{
+		PixelateGraphSchedule& Schedule;
+		std::vector<int32_t> BatchOfPass;
+		int32_t OpenBatches[s_QueueCount]{ -1, -1 }; // batch later passes of the queue are added to, -1 to start a new one
+		int32_t WaitedBatches[s_QueueCount]{ -1, -1 }; // latest batch of the other queue already waited for
+
+		int32_t AddBatch(TimelineQueue queue)
+		{
+			Schedule.Batches.push_back(PixelateSubmissionBatch{ .Queue = queue });
+			return OpenBatches[GetQueueIndex(queue)] = static_cast<int32_t>(Schedule.Batches.size() - 1);
+		}
+
+		// Ends the batch of the pass right after it, so the semaphore signaled at its end doesn't wait for later passes.
+		// Only the open batch of a queue is split, others are followed by later batches of their queue or already waited on.
+		int32_t EndBatchAfter(uint32_t pass)
+		{
+			auto batchIndex = BatchOfPass[pass];
+			auto queueIndex = GetQueueIndex(Schedule.Batches[batchIndex].Queue);
+
+			if (Schedule.Batches[batchIndex].IsWaitedOn || OpenBatches[queueIndex] != batchIndex)
+				return batchIndex;
+
+			auto& passes = Schedule.Batches[batchIndex].Passes;
+			auto passPosition = std::find(passes.begin(), passes.end(), pass) + 1;
+			std::vector<uint32_t> laterPasses(passPosition, passes.end());
+			passes.erase(passPosition, passes.end());
+
+			if (laterPasses.empty())
+			{
+				OpenBatches[queueIndex] = -1;
+				return batchIndex;
+			}
+
+			// Appended after batches of the other queue, which is fine as none of them waits on these passes
+			auto splitBatch = AddBatch(Schedule.Batches[batchIndex].Queue);
+			for (auto laterPass : laterPasses)
+				BatchOfPass[laterPass] = splitBatch;
+			Schedule.Batches[splitBatch].Passes = std::move(laterPasses);
+
+			return batchIndex;
+		}
+
+		void Wait(int32_t batchIndex, int32_t waitBatch)
+		{
+			auto& batch = Schedule.Batches[batchIndex];
+			batch.WaitBatch = std::max(batch.WaitBatch, waitBatch);
+			Schedule.Batches[waitBatch].IsWaitedOn = true;
+			WaitedBatches[GetQueueIndex(batch.Queue)] = batch.WaitBatch;
+		}
+	};
+
+	static int32_t GetFirstSwapchainPass(const std::vector<PixelatePass>& passes, const std::vector<TimelineQueue>& passQueues)
+	{
+		for (uint32_t i = 0; i < passes.size(); i++)
+			if (passes[i].Flags & PIXELATE_PASS_COLOR_OUTPUT_TO_SWAPCHAIN)
+				return i;
+
+		// Nothing writes the swapchain image, the acquire is waited on with the first graphics work
+		for (uint32_t i = 0; i < passes.size(); i++)
+			if (passQueues[i] == TimelineQueue::Graphics)
+				return i;
+
+		return -1;
+	}
+
+	PixelateGraphSchedule Schedule(const std::vector<PixelatePass>& passes, bool hasAsyncComputeQueue)
+	{
+		PixelateGraphSchedule schedule{};
+		schedule.PassQueues.assign(passes.size(), TimelineQueue::Graphics);
+
+		auto passResources = GetPassResources(passes);
+
+		if (hasAsyncComputeQueue)
+		{
+			auto dependencies = GetDependencies(passResources);
+
+			for (uint32_t i = 0; i < passes.size(); i++)
+			{
+				if (passes[i].PassType != PassType::Compute || !HasIndependentGraphicsPass(passes, dependencies, i))
+					continue;
+
+				schedule.PassQueues[i] = TimelineQueue::Compute;
+				schedule.AsyncComputePassCount++;
+			}
+		}
+
+		BatchBuilder builder{ schedule, std::vector<int32_t>(passes.size(), -1) };
+		std::map<std::string, uint32_t> lastAccess{};
+		auto firstSwapchainPass = GetFirstSwapchainPass(passes, schedule.PassQueues);
+
+		for (uint32_t i = 0; i < passes.size(); i++)
+		{
+			auto queue = schedule.PassQueues[i];
+			auto queueIndex = GetQueueIndex(queue);
+
+			// Everything the pass needs from the other queue, the semaphore of the latest batch covers the earlier ones
+			int32_t waitBatch = -1;
+			for (const auto& name : passResources[i])
+			{
+				auto previous = lastAccess.find(name);
+				if (previous != lastAccess.end() && schedule.PassQueues[previous->second] != queue)
+					waitBatch = std::max(waitBatch, builder.EndBatchAfter(previous->second));
+			}
+
+			if (waitBatch <= builder.WaitedBatches[queueIndex])
+				waitBatch = -1;
+
+			// Semaphore waits apply to the start of a batch
+			auto isFirstSwapchainPass = static_cast<int32_t>(i) == firstSwapchainPass;
+			if (builder.OpenBatches[queueIndex] < 0 || waitBatch >= 0 || isFirstSwapchainPass)
+				builder.AddBatch(queue);
+
+			auto batchIndex = builder.OpenBatches[queueIndex];
+			if (waitBatch >= 0)
+				builder.Wait(batchIndex, waitBatch);
+
+			schedule.Batches[batchIndex].WaitsForSwapchainImage |= isFirstSwapchainPass;
+			schedule.Batches[batchIndex].Passes.push_back(i);
+			builder.BatchOfPass[i] = batchIndex;
+
+			for (const auto& name : passResources[i])
+				lastAccess[name] = i;
+		}
+
+		if (firstSwapchainPass < 0)
+			schedule.Batches[builder.AddBatch(TimelineQueue::Graphics)].WaitsForSwapchainImage = true;
+
+		// The frame's timeline value is signaled by the last graphics batch, it has to cover the compute queue as well
+		int32_t lastComputeBatch = -1;
+		for (int32_t i = 0; i < static_cast<int32_t>(schedule.Batches.size()); i++)
+			if (schedule.Batches[i].Queue == TimelineQueue::Compute)
+				lastComputeBatch = i;
+
+		if (lastComputeBatch >= 0)
+		{
+			auto& lastBatch = schedule.Batches.back();
+			if (lastBatch.Queue != TimelineQueue::Graphics || lastBatch.WaitBatch != lastComputeBatch)
+				builder.Wait(builder.AddBatch(TimelineQueue::Graphics), lastComputeBatch);
+		}
+
+		PXL8_CORE_TRACE("Render graph schedule: " + std::to_string(schedule.AsyncComputePassCount) + " of "
+			+ std::to_string(passes.size()) + " passes on the async compute queue, " + std::to_string(schedule.Batches.size()) + " submission batches.");
+
+		return schedule;
+	}
+}
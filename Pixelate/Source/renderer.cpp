@@ -6,9 +6,20 @@
 #include "pixelate_device.h"
 #include "semaphore_manager.h"
 #include "fence_manager.h"
+#include "timeline_manager.h"
+#include "gpu_profiler.h"
+#include "cpu_profiler.h"
+#include "pipeline_cache.h"
+#include "shader_module_cache.h"
+#include "pipeline_manager.h"
+#include "command_buffer_manager.h"
+#include "upload_engine.h"
+#include "bindless_descriptors.h"
+#include "descriptor_allocator.h"
+#include "uniform_ring.h"
+#include "queue_manager.h"
 //#include "pixelate_helpers.h"
 //#include "thread_safe_fifo_queue.h"
-//#include "command_buffer_manager.h"
 //#include "queue_manager.h"
 //#include "resource_manager.h"
 //#include "presentation_engine.h"
@@ -154,7 +165,7 @@ namespace Pixelate
 		score += deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? 300 : 0;
 		score += deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_OTHER ? 200 : 0;
 		score += queueFamilyIndices.GraphicsQueueFamily.has_value() ? 500 : 0;
-		score += queueFamilyIndices.ComputeQueueFamily.has_value() ? 100 : 0;
+		score += queueFamilyIndices.HasAsyncCompute() ? 100 : 0;
 		score += SupportsRayTracing(availableExtensions) ? 1000 : 0;
 		score += SupportsSwapchain(physicalDevice, surface, availableExtensions) ? 1000 : 0;
 
@@ -281,14 +292,53 @@ namespace Pixelate
 		return allSupported;
 	}
 
-	static VkDevice CreateLogicalDevice(VkPhysicalDevice physicalDevice, const Pixelate::QueueFamilyIndices& queueFamilyIndices, VpCapabilities Capabilities, const VpProfileProperties& profile)
+	static OptionalDeviceFeatures GetOptionalDeviceFeatures(VkPhysicalDevice physicalDevice)
+	{
+		OptionalDeviceFeatures optionalFeatures{};
+		auto availableExtensions = GetSupportedDeviceExtensions(physicalDevice);
+
+		auto hasMaintenance5Extension = std::any_of(availableExtensions.begin(), availableExtensions.end(),
+			[](const VkExtensionProperties& extension) { return strcmp(extension.extensionName, VK_KHR_MAINTENANCE_5_EXTENSION_NAME) == 0; });
+
+		if (hasMaintenance5Extension)
+		{
+			VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR };
+			VkPhysicalDeviceFeatures2 features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+			features.pNext = &maintenance5Features;
+			vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+			optionalFeatures.Maintenance5 = maintenance5Features.maintenance5 == VK_TRUE;
+		}
+
+		// Core in Vulkan 1.2 but optional, the profile doesn't require it
+		VkPhysicalDeviceVulkan12Features vulkan12Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+		VkPhysicalDeviceFeatures2 features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+		features.pNext = &vulkan12Features;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+		optionalFeatures.DescriptorIndexing = vulkan12Features.runtimeDescriptorArray == VK_TRUE
+			&& vulkan12Features.descriptorBindingPartiallyBound == VK_TRUE
+			&& vulkan12Features.descriptorBindingVariableDescriptorCount == VK_TRUE
+			&& vulkan12Features.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE
+			&& vulkan12Features.descriptorBindingStorageImageUpdateAfterBind == VK_TRUE
+			&& vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE
+			&& vulkan12Features.shaderSampledImageArrayNonUniformIndexing == VK_TRUE
+			&& vulkan12Features.shaderStorageImageArrayNonUniformIndexing == VK_TRUE
+			&& vulkan12Features.shaderStorageBufferArrayNonUniformIndexing == VK_TRUE;
+
+		return optionalFeatures;
+	}
+
+	static VkDevice CreateLogicalDevice(VkPhysicalDevice physicalDevice, const Pixelate::QueueFamilyIndices& queueFamilyIndices, const OptionalDeviceFeatures& optionalFeatures, VpCapabilities Capabilities, const VpProfileProperties& profile)
 	{
 		std::vector<VkDeviceQueueCreateInfo> deviceQueueCreateInfos{};
 
 		VkDeviceQueueCreateInfo graphicsQueueCreateInfo{};
 		VkDeviceQueueCreateInfo computeQueueCreateInfo{};
+		VkDeviceQueueCreateInfo transferQueueCreateInfo{};
 		auto graphicsQueuePriority = 1.0f;
 		auto computeQueuePriority = 1.0f;
+		auto transferQueuePriority = 1.0f;
 
 		graphicsQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		graphicsQueueCreateInfo.queueFamilyIndex = queueFamilyIndices.GraphicsQueueFamily.value();
@@ -296,7 +346,8 @@ namespace Pixelate
 		graphicsQueueCreateInfo.pQueuePriorities = &graphicsQueuePriority;
 		deviceQueueCreateInfos.push_back(graphicsQueueCreateInfo);
 
-		if (queueFamilyIndices.ComputeQueueFamily.has_value())
+		// Without a separate family compute passes are submitted to the graphics queue
+		if (queueFamilyIndices.HasAsyncCompute())
 		{
 			computeQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 			computeQueueCreateInfo.queueFamilyIndex = queueFamilyIndices.ComputeQueueFamily.value();
@@ -305,9 +356,44 @@ namespace Pixelate
 			deviceQueueCreateInfos.push_back(computeQueueCreateInfo);
 		}
 
+		// Without a separate family uploads are copied on the graphics queue
+		if (queueFamilyIndices.HasDedicatedTransfer())
+		{
+			transferQueueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			transferQueueCreateInfo.queueFamilyIndex = queueFamilyIndices.TransferQueueFamily.value();
+			transferQueueCreateInfo.queueCount = 1;
+			transferQueueCreateInfo.pQueuePriorities = &transferQueuePriority;
+			deviceQueueCreateInfos.push_back(transferQueueCreateInfo);
+		}
+
 		std::vector<const char*> additionaDeviceExtensions{ VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 
 		VkDeviceCreateInfo deviceCreateInfo{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+
+		VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR };
+		if (optionalFeatures.Maintenance5)
+		{
+			additionaDeviceExtensions.push_back(VK_KHR_MAINTENANCE_5_EXTENSION_NAME);
+			maintenance5Features.maintenance5 = VK_TRUE;
+			deviceCreateInfo.pNext = &maintenance5Features; // merged into the profile's feature chain by vpCreateDevice
+		}
+
+		VkPhysicalDeviceVulkan12Features vulkan12Features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+		if (optionalFeatures.DescriptorIndexing)
+		{
+			vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+			vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+			vulkan12Features.descriptorBindingVariableDescriptorCount = VK_TRUE;
+			vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			vulkan12Features.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+			vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+			vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+			vulkan12Features.shaderStorageImageArrayNonUniformIndexing = VK_TRUE;
+			vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+			vulkan12Features.pNext = const_cast<void*>(deviceCreateInfo.pNext); // OR-ed into the profile's Vulkan 1.2 features
+			deviceCreateInfo.pNext = &vulkan12Features;
+		}
+
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(deviceQueueCreateInfos.size());
 		deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfos.data();
 		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(additionaDeviceExtensions.size());
@@ -333,12 +419,12 @@ namespace Pixelate
 		VpProfileProperties profile{};
 
 		profile.specVersion = profileSpecVersion;
-		strncpy_s(profile.profileName, profileName, strlen(profileName));
+		strncpy(profile.profileName, profileName, VP_MAX_PROFILE_NAME_SIZE - 1);
 
 		return profile;
 	}
 
-	static PixelateInstance VulkanProfileBootstrap(const char* applicationName, const char* profileName = PixelateVulkanProfile::PROFILE_NAME, const int profileSpecVersion = PixelateVulkanProfile::PROFILE_SPEC_VERSION, unsigned int minApiVersion = PixelateVulkanProfile::PROFILE_MIN_API_VERSION)
+	static PixelateInstance VulkanProfileBootstrap(const char* applicationName, PresentationBackend presentationBackend, const char* profileName = PixelateVulkanProfile::PROFILE_NAME, const int profileSpecVersion = PixelateVulkanProfile::PROFILE_SPEC_VERSION, unsigned int minApiVersion = PixelateVulkanProfile::PROFILE_MIN_API_VERSION)
 	{
 		Log::Init();
 
@@ -372,14 +458,22 @@ namespace Pixelate
 			CheckInstanceLayerSupport(layers);
 		}
 
-		switch (PLATFORM)
+		// Headless rendering never creates a surface, so it runs on any ICD, including software ones like lavapipe
+		if (presentationBackend == PresentationBackend::Window)
 		{
-		case Platform::Win64:
-			extensions.emplace_back(VK_KHR_surface_extension);
-			extensions.emplace_back(VK_KHR_win32_surface_extension);
-			break;
-		default:
-			PXL8_CORE_ERROR("Platform not supported! (How did you build this?)");
+			switch (PLATFORM)
+			{
+			case Platform::Win64:
+				extensions.emplace_back(VK_KHR_surface_extension);
+				extensions.emplace_back(VK_KHR_win32_surface_extension);
+				break;
+			case Platform::Linux64:
+				extensions.emplace_back(VK_KHR_surface_extension);
+				extensions.emplace_back(VK_KHR_xlib_surface_extension); // SDL2's X11 backend
+				break;
+			default:
+				PXL8_CORE_ERROR("Platform not supported! (How did you build this?)");
+			}
 		}
 
 		auto vkInstanceCreateInfo = VkInstanceCreateInfo();
@@ -427,17 +521,28 @@ namespace Pixelate
 		PixelateDevice device;
 		device.VkPhysicalDevice = physicalDevice;
 		device.QueueFamilyIndices = GetQueueFamilyIndices(physicalDevice, surface);
-		device.VkDevice = CreateLogicalDevice(physicalDevice, device.QueueFamilyIndices, context.ProfileCapabilities, context.ProfileProperties);
+		device.OptionalFeatures = GetOptionalDeviceFeatures(physicalDevice);
+		device.VkDevice = CreateLogicalDevice(physicalDevice, device.QueueFamilyIndices, device.OptionalFeatures, context.ProfileCapabilities, context.ProfileProperties);
 
 		PXL8_CORE_INFO(std::string("Vulkan device created from profile successfully:"));
 		PXL8_CORE_INFO(std::string("    ") + context.ProfileProperties.profileName);
 		PXL8_CORE_INFO(std::string("    Profile Version: ") + std::to_string(context.ProfileProperties.specVersion));
+		PXL8_CORE_INFO(std::string("    VK_KHR_maintenance5: ") + (device.OptionalFeatures.Maintenance5 ? "enabled" : "unsupported"));
+		PXL8_CORE_INFO(std::string("    Descriptor indexing: ") + (device.OptionalFeatures.DescriptorIndexing ? "enabled" : "unsupported"));
+		PXL8_CORE_INFO(std::string("    Async compute queue: ") + (device.QueueFamilyIndices.HasAsyncCompute() ? "family " + std::to_string(device.QueueFamilyIndices.ComputeQueueFamily.value()) : "unavailable, sharing the graphics queue"));
+		PXL8_CORE_INFO(std::string("    Transfer queue: ") + (device.QueueFamilyIndices.HasDedicatedTransfer() ? "family " + std::to_string(device.QueueFamilyIndices.TransferQueueFamily.value()) : "unavailable, sharing the graphics queue"));
 
 		return device;
 	}
 
-	PixelatePresentationEngine CreateSurface(VkInstance instance, const char* applicationName, int x, int y, int width, int height)
+	PixelatePresentationEngine CreateSurface(VkInstance instance, PresentationBackend presentationBackend, const char* applicationName, int x, int y, int width, int height)
 	{
+		if (presentationBackend == PresentationBackend::Headless)
+		{
+			PXL8_CORE_INFO(std::string("Headless presentation for \"") + applicationName + "\", rendering offscreen.");
+			return PixelatePresentationEngine(width, height);
+		}
+
 		VkSurfaceKHR surface;
 		auto window = InitializeSDLWindow(applicationName, x, y, width, height);
 		auto success = SDL_Vulkan_CreateSurface(window, instance, &surface);
@@ -452,65 +557,111 @@ namespace Pixelate
 		return presentationEngine;
 	}
 
-	Renderer::Renderer(const char* applicationName, int x, int y, int width, int height, const char* vulkanProfileName, const int profileSpecVersion, unsigned int minApiVersion) :
-		m_Instance(VulkanProfileBootstrap(applicationName, vulkanProfileName, profileSpecVersion, minApiVersion)),
-		m_Presentation(CreateSurface(m_Instance.Instance, applicationName, x, y, width, height)),
+	Renderer::Renderer(const char* applicationName, int x, int y, int width, int height, PresentationBackend presentationBackend, const char* vulkanProfileName, const int profileSpecVersion, unsigned int minApiVersion) :
+		m_Instance(VulkanProfileBootstrap(applicationName, presentationBackend, vulkanProfileName, profileSpecVersion, minApiVersion)),
+		m_Presentation(CreateSurface(m_Instance.Instance, presentationBackend, applicationName, x, y, width, height)),
 		m_Device(CreatePixelateDevice(m_Instance, m_Presentation.GetSurface())),
-		m_VulkanResourceManager(VulkanResourceManager(m_Instance.Instance, m_Device.VkDevice, m_Device.VkPhysicalDevice, minApiVersion))
+		m_VulkanResourceManager(VulkanResourceManager(m_Instance.Instance, m_Device.VkDevice, m_Device.VkPhysicalDevice, minApiVersion)),
+		m_FramePacer(m_Device)
 	{
-		m_Presentation.Initialize(m_Device);
+		CpuProfiler::SetThreadName("Render");
+		TimelineManager::Initialize(m_Device.VkDevice);
+		BindlessDescriptors::Initialize(m_Device);
+		DescriptorAllocator::Initialize(m_Device.VkDevice);
+		GpuProfiler::Initialize(m_Device);
+		m_Presentation.Initialize(m_Device, m_VulkanResourceManager.GetAllocator());
+		PipelineCache::Initialize(m_Device, PixelateSettings::PIPELINE_CACHE_FILEPATH);
+		ShaderModules::Initialize(m_Device);
+		UploadEngine::Initialize(m_Device, m_VulkanResourceManager.GetAllocator());
+		UniformRing::Initialize(m_Device, m_VulkanResourceManager.GetAllocator());
 	}
 
-	void Renderer::Render(RenderGraph renderGraph, std::function<bool()> inputHandler)
+	void Renderer::Render(RenderGraph& renderGraph, std::function<bool()> inputHandler)
 	{
 		auto quit = false;
 		while (!quit)
 		{
+			CpuProfiler::MarkFrame();
+			PXL8_PROFILE_SCOPE("Renderer::Render");
+
 			quit = inputHandler();
 
-			auto frameInFlightFences = FenceManager::GetFenceGroup(
-				m_Device.VkDevice,
-				FenceGroupDescriptor
-				{
-					.Identifier = FenceIdenfitier::FrameHasBeenPresented,
-					.FenceGroupSize = PixelateSettings::MAX_FRAMES_IN_FLIGHT,
-					.CreateFlags = VK_FENCE_CREATE_SIGNALED_BIT
-				});
-
-			frameInFlightFences.Wait(m_FrameInFlightIndex);
-
-			auto acquireSwapchainImageSemaphore = SemaphoreManager::GetSemaphore(
-				m_Device.VkDevice,
-				VK_PIPELINE_STAGE_2_NONE,
-				SemaphoreDescriptor{
-					SemaphoreIdentifier::SwapchainImageHasBeenAcquired,
-					m_FrameInFlightIndex,
-				});
-
-			// -------------------------------------------------------
-			// TODO: FIGURE OUT WHY swapchainImageIndex is always 0!!!
-			auto swapchainImageIndex = m_Presentation.AcquireSwapcahinImage(acquireSwapchainImageSemaphore);
-			//--------------------------------------------------------
-
-			auto [fence, swapchainImageReadyToPresentSemaphore] = renderGraph.RecordAndSubmit(
+			if (m_Presentation.IsSwapchainOutOfDate() && !RecreateSwapchain(renderGraph))
+			{
+				// Minimized, there is nothing to render into until the window gets an area again
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				continue;
+			}
+
+			auto frame = m_FramePacer.BeginFrame(m_Presentation);
+
+			if (frame.SwapchainImageIndex == INVALID_SWAPCHAIN_IMAGE_INDEX)
+				continue; // out of date on acquire, recreated before the slot is begun again
+
+			m_Presentation.DisposeRetiredSwapchains();
+			m_VulkanResourceManager.DisposeRetiredResources();
+
+			// Uploads made before this point are visible to the frame's passes
+			UploadEngine::Flush(frame.FrameInFlightIndex);
+
+			auto swapchainImageReadyToPresentSemaphore = renderGraph.RecordAndSubmit(
 				m_Device,
-				m_FrameInFlightIndex,
-				swapchainImageIndex,
-				&acquireSwapchainImageSemaphore.SemaphoreSubmitInfo, 1,
-				m_Presentation.GetSwapchain());
+				frame.FrameInFlightIndex,
+				frame.SwapchainImageIndex,
+				&frame.ImageAcquiredSemaphore.SemaphoreSubmitInfo, 1,
+				m_Presentation.GetSwapchain(),
+				frame.FrameComplete);
 
 			m_Presentation.Present(
-				swapchainImageIndex,
+				frame.SwapchainImageIndex,
 				&swapchainImageReadyToPresentSemaphore.SemaphoreSubmitInfo, 1
 			);
 
-			m_FrameInFlightIndex = (m_FrameInFlightIndex + 1) % PixelateSettings::MAX_FRAMES_IN_FLIGHT;
+			m_FramePacer.EndFrame();
 		}
+
+		// Frames may still be in flight, let them finish before anything gets disposed
+		QueueManager::DeviceWaitIdle(m_Device.VkDevice);
+	}
+
+	bool Renderer::RecreateSwapchain(RenderGraph& renderGraph)
+	{
+		PXL8_PROFILE_SCOPE("Renderer::RecreateSwapchain");
+
+		auto recreationStart = std::chrono::steady_clock::now();
+
+		// Every frame submitted so far may still use the current images
+		auto retireAfter = TimelineManager::GetLastReserved(TimelineQueue::Graphics);
+
+		if (!m_Presentation.RecreateSwapchain(retireAfter))
+			return false;
+
+		renderGraph.OnSwapchainRecreated(m_Device, m_VulkanResourceManager, m_Presentation.GetSwapchain(), retireAfter);
+
+		auto recreationTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recreationStart).count();
+
+		auto& statistics = m_SwapchainRecreationStatistics;
+		statistics.RecreationCount++;
+		statistics.LastTime = recreationTime;
+		statistics.TimeMin = std::min(statistics.TimeMin, recreationTime);
+		statistics.TimeMax = std::max(statistics.TimeMax, recreationTime);
+		statistics.TimeSum += recreationTime;
+
+		PXL8_CORE_TRACE("Swapchain and render graph recreated in " + std::to_string(recreationTime) + " ms.");
+
+		return true;
 	}
 
 	RenderGraph Renderer::BuildRenderGraph(RenderGraphDescriptor& renderGraphDescriptor)
 	{
-		return RenderGraph(m_Device, renderGraphDescriptor, m_Presentation.GetSwapchain());
+		auto buildStart = std::chrono::steady_clock::now();
+
+		auto renderGraph = RenderGraph(m_Device, m_VulkanResourceManager, renderGraphDescriptor, m_Presentation.GetSwapchain());
+
+		auto buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+		PXL8_CORE_INFO("Render graph with " + std::to_string(renderGraphDescriptor.Passes.size()) + " passes built in " + std::to_string(buildTime) + " ms.");
+
+		return renderGraph;
 	}
 
 	const SDL_Window* Renderer::GetWindow() const
@@ -523,8 +674,20 @@ namespace Pixelate
 		if (m_Instance.Instance == VK_NULL_HANDLE)
 			return; // is disposed already
 
+		RenderGraph::DisposeRecordingWorkers();
+		Pipelines::Dispose(m_Device.VkDevice);
+		ShaderModules::Dispose(m_Device.VkDevice);
+		PipelineCache::Dispose(m_Device.VkDevice);
+		CommandBufferManager::Dispose(m_Device.VkDevice);
+		DescriptorAllocator::Dispose();
+		UploadEngine::Dispose();
+		UniformRing::Dispose();
+		BindlessDescriptors::Dispose(m_Device.VkDevice);
+		m_VulkanResourceManager.Dispose();
 		FenceManager::Dispose();
 		SemaphoreManager::Dispose(m_Device.VkDevice);
+		TimelineManager::Dispose();
+		GpuProfiler::Dispose();
 		m_Presentation.Dispose(m_Instance.Instance);
 		vkDestroyDevice(m_Device.VkDevice, nullptr);
 		DestroyDebugUtilsMessengerEXT(m_Instance.Instance, m_Instance.DebugMessenger, 0);
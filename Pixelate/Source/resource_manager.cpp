@@ -1,6 +1,434 @@
+#include <algorithm>
 #include "resource_manager.h"
+#include "hasher.h"
+#include "log.h"
 
 namespace Pixelate
 {
-	
+	const TransientResource* TransientResourceSet::Find(const char* name) const
+	{
+		auto resource = Resources.find(name);
+		return resource != Resources.end() ? &resource->second : nullptr;
+	}
+
+	static bool HasLazilyAllocatedMemory(VmaAllocator allocator)
+	{
+		const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+		vmaGetMemoryProperties(allocator, &pMemoryProperties);
+
+		for (uint32_t i = 0; i < pMemoryProperties->memoryTypeCount; i++)
+			if (pMemoryProperties->memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+				return true;
+
+		return false;
+	}
+
+	VulkanResourceManager::VulkanResourceManager(VkInstance instance, VkDevice device, VkPhysicalDevice physicalDevice, unsigned int vulkanApiVersion)
+		: m_Device(device), m_VmaAllocator(CreateVmaAllocator(instance, device, physicalDevice, vulkanApiVersion))
+	{
+		m_HasLazilyAllocatedMemory = HasLazilyAllocatedMemory(m_VmaAllocator);
+	}
+
+	VkImageView VulkanResourceManager::RequestImageView(ImageViewDescriptor imageViewDescriptor)
+	{
+		Hasher hasher;
+		hasher.Hash(imageViewDescriptor.Name);
+		auto hash = hasher.GetValue();
+
+		auto imageView = m_ImageViews.find(hash);
+		if (imageView != m_ImageViews.end())
+			return *imageView->second;
+
+		VkImageView vkImageView = VK_NULL_HANDLE;
+		if (vkCreateImageView(m_Device, &imageViewDescriptor.Descriptor, nullptr, &vkImageView) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create image view \"" + imageViewDescriptor.Name + "\"!");
+			return VK_NULL_HANDLE;
+		}
+
+		m_ImageViews.insert(std::make_pair(hash, std::make_shared<VkImageView>(vkImageView)));
+
+		return vkImageView;
+	}
+
+	static VkImageViewType GetImageViewType(VkImageType imageType)
+	{
+		switch (imageType)
+		{
+		case VK_IMAGE_TYPE_1D: return VK_IMAGE_VIEW_TYPE_1D;
+		case VK_IMAGE_TYPE_3D: return VK_IMAGE_VIEW_TYPE_3D;
+		default: return VK_IMAGE_VIEW_TYPE_2D;
+		}
+	}
+
+	PixelateBuffer VulkanResourceManager::CreateBuffer(const BufferDescriptor& descriptor)
+	{
+		VkBufferCreateInfo bufferCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.size = descriptor.Size,
+			.usage = descriptor.Usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		};
+
+		VmaAllocationCreateInfo allocationCreateInfo
+		{
+			.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+		};
+
+		PixelateBuffer buffer{ .Size = descriptor.Size };
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		if (vmaCreateBuffer(m_VmaAllocator, &bufferCreateInfo, &allocationCreateInfo, &buffer.Buffer, &allocation, nullptr) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR(std::string("Failed to create buffer \"") + descriptor.Name + "\"!");
+			return PixelateBuffer{};
+		}
+
+		m_Buffers.push_back(buffer.Buffer);
+		m_Allocations.push_back(allocation);
+
+		if (descriptor.Usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+			buffer.StorageIndex = BindlessDescriptors::RegisterStorageBuffer(buffer.Buffer);
+
+		return buffer;
+	}
+
+	PixelateImage VulkanResourceManager::CreateImage(const ImageDescriptor& descriptor)
+	{
+		auto imageCreateInfo = descriptor.ImageCreateInfo;
+		imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+		VmaAllocationCreateInfo allocationCreateInfo
+		{
+			.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+		};
+
+		PixelateImage image{ .Extent = imageCreateInfo.extent, .Format = imageCreateInfo.format };
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		if (vmaCreateImage(m_VmaAllocator, &imageCreateInfo, &allocationCreateInfo, &image.Image, &allocation, nullptr) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR(std::string("Failed to create image \"") + descriptor.Name + "\"!");
+			return PixelateImage{};
+		}
+
+		m_Images.push_back(image.Image);
+		m_Allocations.push_back(allocation);
+
+		image.ImageView = RequestImageView(ImageViewDescriptor
+			{
+				.Name = std::string("Image/") + descriptor.Name + "/" + std::to_string(reinterpret_cast<uint64_t>(image.Image)),
+				.Descriptor = VkImageViewCreateInfo
+				{
+					.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+					.image = image.Image,
+					.viewType = GetImageViewType(imageCreateInfo.imageType),
+					.format = imageCreateInfo.format,
+					.subresourceRange = { descriptor.ImageAspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS },
+				},
+			});
+
+		if (imageCreateInfo.usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+			image.SampledIndex = BindlessDescriptors::RegisterSampledImage(image.ImageView);
+		if (imageCreateInfo.usage & VK_IMAGE_USAGE_STORAGE_BIT)
+			image.StorageIndex = BindlessDescriptors::RegisterStorageImage(image.ImageView);
+
+		return image;
+	}
+
+	// A range of device memory shared by resources that are never alive at the same time
+	struct AliasedMemoryBlock
+	{
+		VkMemoryRequirements MemoryRequirements{};
+		std::vector<size_t> Occupants{}; // indices into the descriptors, sorted by first use once placement is done
+		bool IsShared = true;
+	};
+
+	static bool LifetimesOverlap(const TransientResourceDescriptor& a, const TransientResourceDescriptor& b)
+	{
+		return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+	}
+
+	// Greedy interval packing: largest resources first, each goes into the first block it fits without overlapping a lifetime
+	static std::vector<AliasedMemoryBlock> PlaceResources(
+		const std::vector<TransientResourceDescriptor>& descriptors,
+		const std::vector<VkMemoryRequirements>& memoryRequirements,
+		const std::vector<size_t>& placedResources)
+	{
+		auto order = placedResources;
+		std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return memoryRequirements[a].size > memoryRequirements[b].size; });
+
+		std::vector<AliasedMemoryBlock> blocks{};
+
+		for (auto resourceIndex : order)
+		{
+			const auto& descriptor = descriptors[resourceIndex];
+			const auto& requirements = memoryRequirements[resourceIndex];
+
+			AliasedMemoryBlock* pBlock = nullptr;
+			for (auto& block : blocks)
+			{
+				if (!block.IsShared || !descriptor.CanAlias || !(block.MemoryRequirements.memoryTypeBits & requirements.memoryTypeBits))
+					continue;
+
+				auto overlaps = std::any_of(block.Occupants.begin(), block.Occupants.end(),
+					[&](size_t occupant) { return LifetimesOverlap(descriptors[occupant], descriptor); });
+
+				if (!overlaps)
+				{
+					pBlock = &block;
+					break;
+				}
+			}
+
+			if (pBlock == nullptr)
+			{
+				pBlock = &blocks.emplace_back();
+				pBlock->MemoryRequirements = requirements;
+				pBlock->IsShared = descriptor.CanAlias;
+			}
+
+			pBlock->MemoryRequirements.size = std::max(pBlock->MemoryRequirements.size, requirements.size);
+			pBlock->MemoryRequirements.alignment = std::max(pBlock->MemoryRequirements.alignment, requirements.alignment);
+			pBlock->MemoryRequirements.memoryTypeBits &= requirements.memoryTypeBits;
+			pBlock->Occupants.push_back(resourceIndex);
+		}
+
+		for (auto& block : blocks)
+			std::sort(block.Occupants.begin(), block.Occupants.end(), [&](size_t a, size_t b) { return descriptors[a].FirstPass < descriptors[b].FirstPass; });
+
+		return blocks;
+	}
+
+	TransientResourceSet VulkanResourceManager::AllocateTransientResources(const std::vector<TransientResourceDescriptor>& descriptors)
+	{
+		TransientResourceSet resourceSet{};
+
+		std::vector<VkMemoryRequirements> memoryRequirements(descriptors.size());
+		std::vector<TransientResource*> resources(descriptors.size(), nullptr);
+		std::vector<size_t> placedResources{};
+
+		for (size_t i = 0; i < descriptors.size(); i++)
+		{
+			const auto& descriptor = descriptors[i];
+			TransientResource resource{};
+			resource.Type = descriptor.Type;
+
+			if (descriptor.Type == PixelateResourceType::Image)
+			{
+				auto imageCreateInfo = descriptor.ImageCreateInfo;
+				resource.IsTransientAttachment = descriptor.IsTransientAttachment && m_HasLazilyAllocatedMemory;
+				if (resource.IsTransientAttachment)
+					imageCreateInfo.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+				if (vkCreateImage(m_Device, &imageCreateInfo, nullptr, &resource.Image) != VK_SUCCESS)
+				{
+					PXL8_CORE_ERROR(std::string("Failed to create render graph image \"") + descriptor.Name + "\"!");
+					continue;
+				}
+
+				m_Images.push_back(resource.Image);
+				resource.Extent = { imageCreateInfo.extent.width, imageCreateInfo.extent.height };
+				vkGetImageMemoryRequirements(m_Device, resource.Image, &memoryRequirements[i]);
+			}
+			else
+			{
+				if (vkCreateBuffer(m_Device, &descriptor.BufferCreateInfo, nullptr, &resource.Buffer) != VK_SUCCESS)
+				{
+					PXL8_CORE_ERROR(std::string("Failed to create render graph buffer \"") + descriptor.Name + "\"!");
+					continue;
+				}
+
+				m_Buffers.push_back(resource.Buffer);
+				vkGetBufferMemoryRequirements(m_Device, resource.Buffer, &memoryRequirements[i]);
+			}
+
+			resourceSet.Statistics.RequestedBytes += memoryRequirements[i].size;
+			resources[i] = &resourceSet.Resources.insert_or_assign(descriptor.Name, resource).first->second;
+
+			// Transient attachments get their own lazily allocated memory, there is nothing to gain from aliasing memory that is never backed
+			if (resource.IsTransientAttachment)
+			{
+				VmaAllocationCreateInfo allocationCreateInfo
+				{
+					.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED,
+				};
+
+				VmaAllocation allocation = VK_NULL_HANDLE;
+				if (vmaAllocateMemory(m_VmaAllocator, &memoryRequirements[i], &allocationCreateInfo, &allocation, nullptr) == VK_SUCCESS)
+				{
+					m_Allocations.push_back(allocation);
+					resourceSet.Allocations.push_back(allocation);
+					vmaBindImageMemory2(m_VmaAllocator, allocation, 0, resource.Image, nullptr);
+					resourceSet.Statistics.LazilyAllocatedBytes += memoryRequirements[i].size;
+					continue;
+				}
+
+				PXL8_CORE_WARN(std::string("No lazily allocated memory for transient attachment \"") + descriptor.Name + "\", falling back to device memory.");
+			}
+
+			placedResources.push_back(i);
+		}
+
+		auto blocks = PlaceResources(descriptors, memoryRequirements, placedResources);
+
+		for (const auto& block : blocks)
+		{
+			VmaAllocationCreateInfo allocationCreateInfo
+			{
+				.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			};
+
+			VmaAllocation allocation = VK_NULL_HANDLE;
+			if (vmaAllocateMemory(m_VmaAllocator, &block.MemoryRequirements, &allocationCreateInfo, &allocation, nullptr) != VK_SUCCESS)
+			{
+				PXL8_CORE_ERROR("Failed to allocate " + std::to_string(block.MemoryRequirements.size) + " bytes for render graph resources!");
+				continue;
+			}
+
+			m_Allocations.push_back(allocation);
+			resourceSet.Allocations.push_back(allocation);
+			resourceSet.Statistics.AllocatedBytes += block.MemoryRequirements.size;
+			resourceSet.Statistics.MemoryBlockCount++;
+
+			for (size_t i = 0; i < block.Occupants.size(); i++)
+			{
+				auto occupant = block.Occupants[i];
+				auto& resource = *resources[occupant];
+
+				if (resource.Type == PixelateResourceType::Image)
+					vmaBindImageMemory2(m_VmaAllocator, allocation, 0, resource.Image, nullptr);
+				else
+					vmaBindBufferMemory2(m_VmaAllocator, allocation, 0, resource.Buffer, nullptr);
+
+				// The next frame's first occupant takes over from this frame's last one
+				if (block.Occupants.size() > 1)
+					resource.AliasPredecessor = descriptors[block.Occupants[(i + block.Occupants.size() - 1) % block.Occupants.size()]].Name;
+			}
+		}
+
+		for (size_t i = 0; i < descriptors.size(); i++)
+		{
+			if (resources[i] == nullptr || resources[i]->Type != PixelateResourceType::Image)
+				continue;
+
+			resources[i]->ImageView = RequestImageView(ImageViewDescriptor
+				{
+					.Name = std::string("RenderGraph/") + descriptors[i].Name + "/" + std::to_string(reinterpret_cast<uint64_t>(resources[i]->Image)),
+					.Descriptor = VkImageViewCreateInfo
+					{
+						.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+						.image = resources[i]->Image,
+						.viewType = GetImageViewType(descriptors[i].ImageCreateInfo.imageType),
+						.format = descriptors[i].ImageCreateInfo.format,
+						.subresourceRange = { descriptors[i].ImageAspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS },
+					},
+				});
+		}
+
+		const auto& statistics = resourceSet.Statistics;
+		PXL8_CORE_INFO("Render graph resources: " + std::to_string(descriptors.size()) + " resources requested "
+			+ std::to_string(statistics.RequestedBytes) + " bytes, allocated " + std::to_string(statistics.AllocatedBytes)
+			+ " bytes in " + std::to_string(statistics.MemoryBlockCount) + " blocks, " + std::to_string(statistics.BytesSaved())
+			+ " bytes saved (" + std::to_string(statistics.LazilyAllocatedBytes) + " of them by lazily allocated memory).");
+
+		return resourceSet;
+	}
+
+	template <typename T>
+	static void EraseHandles(std::vector<T>& handles, const std::vector<T>& erasedHandles)
+	{
+		std::erase_if(handles, [&](T handle) { return std::find(erasedHandles.begin(), erasedHandles.end(), handle) != erasedHandles.end(); });
+	}
+
+	void VulkanResourceManager::RetireTransientResources(const TransientResourceSet& resourceSet, TimelinePoint retireAfter)
+	{
+		RetiredResources retired{};
+		retired.RetireAfter = retireAfter;
+		retired.Allocations = resourceSet.Allocations;
+
+		for (const auto& [name, resource] : resourceSet.Resources)
+		{
+			if (resource.Image != VK_NULL_HANDLE)
+				retired.Images.push_back(resource.Image);
+			if (resource.ImageView != VK_NULL_HANDLE)
+				retired.ImageViews.push_back(resource.ImageView);
+			if (resource.Buffer != VK_NULL_HANDLE)
+				retired.Buffers.push_back(resource.Buffer);
+		}
+
+		// No longer owned by the manager itself, so Dispose doesn't destroy them twice
+		EraseHandles(m_Images, retired.Images);
+		EraseHandles(m_Buffers, retired.Buffers);
+		EraseHandles(m_Allocations, retired.Allocations);
+		std::erase_if(m_ImageViews, [&](const auto& imageView)
+			{
+				return std::find(retired.ImageViews.begin(), retired.ImageViews.end(), *imageView.second) != retired.ImageViews.end();
+			});
+
+		m_RetiredResources.push_back(std::move(retired));
+	}
+
+	void VulkanResourceManager::DisposeRetiredResources()
+	{
+		// Retired in submission order, so the first incomplete one ends the search
+		size_t disposedCount = 0;
+		for (; disposedCount < m_RetiredResources.size(); disposedCount++)
+		{
+			if (!TimelineManager::IsComplete(m_RetiredResources[disposedCount].RetireAfter))
+				break;
+
+			DisposeRetired(m_RetiredResources[disposedCount]);
+		}
+
+		m_RetiredResources.erase(m_RetiredResources.begin(), m_RetiredResources.begin() + disposedCount);
+	}
+
+	void VulkanResourceManager::DisposeRetired(RetiredResources& retired)
+	{
+		for (auto imageView : retired.ImageViews)
+			vkDestroyImageView(m_Device, imageView, nullptr);
+
+		for (auto image : retired.Images)
+			vkDestroyImage(m_Device, image, nullptr);
+
+		for (auto buffer : retired.Buffers)
+			vkDestroyBuffer(m_Device, buffer, nullptr);
+
+		for (auto allocation : retired.Allocations)
+			vmaFreeMemory(m_VmaAllocator, allocation);
+
+		retired = RetiredResources{};
+	}
+
+	void VulkanResourceManager::Dispose()
+	{
+		if (m_VmaAllocator == VK_NULL_HANDLE)
+			return;
+
+		for (auto& retired : m_RetiredResources)
+			DisposeRetired(retired);
+		m_RetiredResources.clear();
+
+		for (const auto& [hash, imageView] : m_ImageViews)
+			vkDestroyImageView(m_Device, *imageView, nullptr);
+
+		for (auto image : m_Images)
+			vkDestroyImage(m_Device, image, nullptr);
+
+		for (auto buffer : m_Buffers)
+			vkDestroyBuffer(m_Device, buffer, nullptr);
+
+		for (auto allocation : m_Allocations)
+			vmaFreeMemory(m_VmaAllocator, allocation);
+
+		m_ImageViews.clear();
+		m_Images.clear();
+		m_Buffers.clear();
+		m_Allocations.clear();
+
+		vmaDestroyAllocator(m_VmaAllocator);
+		m_VmaAllocator = VK_NULL_HANDLE;
+
+		PXL8_CORE_TRACE("Vulkan resource manager disposed successfully.");
+	}
 }
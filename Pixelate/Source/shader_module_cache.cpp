@@ -0,0 +1,141 @@
+#include <mutex>
+#include <unordered_map>
+#include "shader_module_cache.h"
+#include "pixelate_helpers.h"
+#include "hasher.h"
+#include "log.h"
+
+namespace Pixelate::ShaderModules
+{
+	struct ShaderModuleEntry
+	{
+		Helpers::MappedFile SpirvFile;
+		VkShaderModule Module = VK_NULL_HANDLE;
+		uint32_t ReferenceCount = 0;
+	};
+
+	VkDevice g_Device = VK_NULL_HANDLE;
+	bool g_InlineSpirv = false;
+
+	std::mutex g_ShaderModulesMutex;
+	std::unordered_map<std::string, uint64_t> g_ContentHashes{}; // by path
+	std::unordered_map<uint64_t, ShaderModuleEntry> g_ShaderModules{}; // by content hash
+	uint32_t g_CreatedModuleCount = 0;
+	uint32_t g_AcquireCount = 0;
+
+	static uint64_t HashSpirv(const Helpers::MappedFile& spirvFile)
+	{
+		Hasher hasher;
+		hasher.Hash(spirvFile.GetData(), spirvFile.GetSize());
+		return hasher.GetValue();
+	}
+
+	static VkShaderModuleCreateInfo GetShaderModuleCreateInfo(const Helpers::MappedFile& spirvFile)
+	{
+		// Mappings are page aligned, so the words can be read in place
+		return VkShaderModuleCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+			.codeSize = spirvFile.GetSize(),
+			.pCode = reinterpret_cast<const uint32_t*>(spirvFile.GetData()),
+		};
+	}
+
+	void Initialize(PixelateDevice device)
+	{
+		g_Device = device.VkDevice;
+		g_InlineSpirv = device.OptionalFeatures.Maintenance5;
+	}
+
+	uint64_t GetContentHash(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(g_ShaderModulesMutex);
+
+		auto contentHash = g_ContentHashes.find(path);
+		if (contentHash != g_ContentHashes.end())
+			return contentHash->second;
+
+		Helpers::MappedFile spirvFile(path);
+		return g_ContentHashes.emplace(path, HashSpirv(spirvFile)).first->second;
+	}
+
+	ShaderStageCode Acquire(const std::string& path)
+	{
+		std::lock_guard<std::mutex> lock(g_ShaderModulesMutex);
+		g_AcquireCount++;
+
+		Helpers::MappedFile spirvFile{};
+
+		auto contentHash = g_ContentHashes.find(path);
+		if (contentHash == g_ContentHashes.end())
+		{
+			spirvFile = Helpers::MappedFile(path);
+			contentHash = g_ContentHashes.emplace(path, HashSpirv(spirvFile)).first;
+		}
+
+		auto& entry = g_ShaderModules[contentHash->second];
+
+		if (entry.ReferenceCount == 0)
+		{
+			entry.SpirvFile = spirvFile.IsValid() ? std::move(spirvFile) : Helpers::MappedFile(path);
+
+			if (!g_InlineSpirv)
+			{
+				auto createInfo = GetShaderModuleCreateInfo(entry.SpirvFile);
+				if (vkCreateShaderModule(g_Device, &createInfo, nullptr, &entry.Module) != VK_SUCCESS)
+					PXL8_CORE_ERROR("Failed to create shader module from spirv byte data: " + path);
+
+				g_CreatedModuleCount++;
+			}
+		}
+
+		entry.ReferenceCount++;
+
+		return ShaderStageCode
+		{
+			.ContentHash = contentHash->second,
+			.Module = entry.Module,
+			.CreateInfo = GetShaderModuleCreateInfo(entry.SpirvFile),
+		};
+	}
+
+	void Release(const ShaderStageCode& code)
+	{
+		std::lock_guard<std::mutex> lock(g_ShaderModulesMutex);
+
+		auto entry = g_ShaderModules.find(code.ContentHash);
+		if (entry == g_ShaderModules.end() || entry->second.ReferenceCount == 0)
+		{
+			PXL8_CORE_WARN("Released a shader module that wasn't acquired.");
+			return;
+		}
+
+		// Pipelines don't reference their modules after creation
+		if (--entry->second.ReferenceCount == 0)
+		{
+			vkDestroyShaderModule(g_Device, entry->second.Module, nullptr);
+			g_ShaderModules.erase(entry);
+		}
+	}
+
+	void Dispose(VkDevice device)
+	{
+		std::lock_guard<std::mutex> lock(g_ShaderModulesMutex);
+
+		if (!g_ShaderModules.empty())
+			PXL8_CORE_WARN(std::to_string(g_ShaderModules.size()) + " shader modules were still acquired on dispose.");
+
+		for (auto& [contentHash, entry] : g_ShaderModules)
+			vkDestroyShaderModule(device, entry.Module, nullptr);
+
+		if (g_AcquireCount > 0)
+			PXL8_CORE_INFO(std::to_string(g_AcquireCount) + " shader stages used " + std::to_string(g_CreatedModuleCount) + " shader modules"
+				+ (g_InlineSpirv ? ", SPIR-V was passed inline." : "."));
+
+		g_ShaderModules.clear();
+		g_ContentHashes.clear();
+		g_CreatedModuleCount = 0;
+		g_AcquireCount = 0;
+		g_Device = VK_NULL_HANDLE;
+	}
+}
@@ -0,0 +1,147 @@
+#include <atomic>
+#include "timeline_manager.h"
+#include "log.h"
+#include "cpu_profiler.h"
+
+namespace Pixelate::TimelineManager
+{
+	struct Timeline
+	{
+		VkSemaphore Semaphore = VK_NULL_HANDLE;
+		std::atomic<uint64_t> LastReserved = 0;
+		std::atomic<uint64_t> LastCompleted = 0; // cached so completed points don't cost a host call
+	};
+
+	VkDevice g_Device = VK_NULL_HANDLE;
+	Timeline g_Timelines[TIMELINE_QUEUE_COUNT];
+
+	static Timeline& GetTimeline(TimelineQueue queue)
+	{
+		return g_Timelines[static_cast<uint32_t>(queue)];
+	}
+
+	static void UpdateLastCompleted(Timeline& timeline, uint64_t value)
+	{
+		auto lastCompleted = timeline.LastCompleted.load(std::memory_order_relaxed);
+		while (lastCompleted < value && !timeline.LastCompleted.compare_exchange_weak(lastCompleted, value, std::memory_order_relaxed));
+	}
+
+	void Initialize(VkDevice device)
+	{
+		g_Device = device;
+
+		VkSemaphoreTypeCreateInfo typeCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+			.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+			.initialValue = 0,
+		};
+
+		VkSemaphoreCreateInfo createInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+			.pNext = &typeCreateInfo,
+		};
+
+		for (auto& timeline : g_Timelines)
+		{
+			if (vkCreateSemaphore(device, &createInfo, nullptr, &timeline.Semaphore) != VK_SUCCESS)
+				PXL8_CORE_ERROR("Failed to create timeline semaphore!");
+
+			timeline.LastReserved = 0;
+			timeline.LastCompleted = 0;
+		}
+
+		PXL8_CORE_TRACE("Queue timelines created successfully.");
+	}
+
+	VkSemaphore GetSemaphore(TimelineQueue queue)
+	{
+		return GetTimeline(queue).Semaphore;
+	}
+
+	TimelinePoint Reserve(TimelineQueue queue)
+	{
+		return TimelinePoint{ queue, GetTimeline(queue).LastReserved.fetch_add(1, std::memory_order_relaxed) + 1 };
+	}
+
+	TimelinePoint GetLastReserved(TimelineQueue queue)
+	{
+		return TimelinePoint{ queue, GetTimeline(queue).LastReserved.load(std::memory_order_relaxed) };
+	}
+
+	bool IsComplete(TimelinePoint point)
+	{
+		auto& timeline = GetTimeline(point.Queue);
+
+		if (point.Value <= timeline.LastCompleted.load(std::memory_order_relaxed))
+			return true;
+
+		uint64_t value = 0;
+		vkGetSemaphoreCounterValue(g_Device, timeline.Semaphore, &value);
+		UpdateLastCompleted(timeline, value);
+
+		return point.Value <= value;
+	}
+
+	void Wait(TimelinePoint point, uint64_t timeout)
+	{
+		auto& timeline = GetTimeline(point.Queue);
+
+		if (point.Value <= timeline.LastCompleted.load(std::memory_order_relaxed))
+			return;
+
+		PXL8_PROFILE_SCOPE("TimelineManager::Wait");
+
+		VkSemaphoreWaitInfo waitInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+			.semaphoreCount = 1,
+			.pSemaphores = &timeline.Semaphore,
+			.pValues = &point.Value,
+		};
+
+		auto result = vkWaitSemaphores(g_Device, &waitInfo, timeout);
+
+		if (result == VK_SUCCESS)
+			UpdateLastCompleted(timeline, point.Value);
+		else if (result != VK_TIMEOUT)
+			PXL8_CORE_ERROR("Failed to wait for timeline semaphore!");
+	}
+
+	void Signal(TimelinePoint point)
+	{
+		VkSemaphoreSignalInfo signalInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO,
+			.semaphore = GetTimeline(point.Queue).Semaphore,
+			.value = point.Value,
+		};
+
+		if (vkSignalSemaphore(g_Device, &signalInfo) != VK_SUCCESS)
+			PXL8_CORE_ERROR("Failed to signal timeline semaphore from the host!");
+	}
+
+	VkSemaphoreSubmitInfo GetSubmitInfo(TimelinePoint point, VkPipelineStageFlags2 stageMask)
+	{
+		return VkSemaphoreSubmitInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+			.semaphore = GetTimeline(point.Queue).Semaphore,
+			.value = point.Value,
+			.stageMask = stageMask,
+			.deviceIndex = 0,
+		};
+	}
+
+	void Dispose()
+	{
+		for (auto& timeline : g_Timelines)
+		{
+			vkDestroySemaphore(g_Device, timeline.Semaphore, nullptr);
+			timeline.Semaphore = VK_NULL_HANDLE;
+		}
+
+		g_Device = VK_NULL_HANDLE;
+	}
+}
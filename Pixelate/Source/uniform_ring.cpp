@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <atomic>
+#include "uniform_ring.h"
+#include "pixelate_settings.h"
+#include "log.h"
+
+namespace Pixelate::UniformRing
+{
+	static constexpr VkDeviceSize s_FrameSize = PixelateSettings::UNIFORM_RING_FRAME_SIZE;
+
+	VmaAllocator g_Allocator = VK_NULL_HANDLE;
+	VkBuffer g_Buffer = VK_NULL_HANDLE;
+	VmaAllocation g_Allocation = VK_NULL_HANDLE;
+	uint8_t* g_pMapped = nullptr;
+	VkDeviceAddress g_DeviceAddress = 0;
+	VkDeviceSize g_Alignment = 256;
+	VkDeviceSize g_MaxBindingRange = 0;
+	std::atomic<uint64_t> g_FrameHeads[PixelateSettings::MAX_FRAMES_IN_FLIGHT]{}; // bytes handed out from each frame's part
+	uint64_t g_PeakFrameUsage = 0;
+
+	void Initialize(PixelateDevice device, VmaAllocator allocator)
+	{
+		g_Allocator = allocator;
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device.VkPhysicalDevice, &properties);
+		g_Alignment = std::max(properties.limits.minUniformBufferOffsetAlignment, properties.limits.minStorageBufferOffsetAlignment);
+		g_MaxBindingRange = std::min<VkDeviceSize>(properties.limits.maxUniformBufferRange, s_FrameSize);
+
+		VkBufferCreateInfo bufferCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.size = s_FrameSize * PixelateSettings::MAX_FRAMES_IN_FLIGHT,
+			.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		};
+
+		// Written with memcpy only and read by the GPU once, coherent so nothing has to be flushed before submitting
+		VmaAllocationCreateInfo allocationCreateInfo
+		{
+			.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+			.usage = VMA_MEMORY_USAGE_AUTO,
+			.requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		};
+
+		VmaAllocationInfo allocationInfo{};
+		if (vmaCreateBuffer(allocator, &bufferCreateInfo, &allocationCreateInfo, &g_Buffer, &g_Allocation, &allocationInfo) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create the uniform ring!");
+			return;
+		}
+
+		g_pMapped = static_cast<uint8_t*>(allocationInfo.pMappedData);
+
+		VkBufferDeviceAddressInfo addressInfo{ .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO, .buffer = g_Buffer };
+		g_DeviceAddress = vkGetBufferDeviceAddress(device.VkDevice, &addressInfo);
+
+		PXL8_CORE_TRACE("Uniform ring created with " + std::to_string(s_FrameSize) + " bytes per frame in flight.");
+	}
+
+	UniformAllocation Allocate(uint32_t frameInFlightIndex, VkDeviceSize size)
+	{
+		if (g_pMapped == nullptr)
+			return UniformAllocation{};
+
+		// Every size is a multiple of the alignment, so every head is aligned
+		auto alignedSize = (size + g_Alignment - 1) / g_Alignment * g_Alignment;
+		auto frameOffset = g_FrameHeads[frameInFlightIndex].fetch_add(alignedSize, std::memory_order_relaxed);
+
+		if (frameOffset + alignedSize > s_FrameSize)
+		{
+			// Only the allocation that crosses the end logs, the ones after it fail silently
+			if (frameOffset <= s_FrameSize)
+				PXL8_CORE_ERROR("The uniform ring is full for this frame, raise UNIFORM_RING_FRAME_SIZE above " + std::to_string(s_FrameSize) + " bytes!");
+
+			return UniformAllocation{};
+		}
+
+		auto offset = frameInFlightIndex * s_FrameSize + frameOffset;
+
+		return UniformAllocation
+		{
+			.pData = g_pMapped + offset,
+			.Buffer = g_Buffer,
+			.Offset = offset,
+			.Size = size,
+			.DeviceAddress = g_DeviceAddress + offset,
+		};
+	}
+
+	VkBuffer GetBuffer()
+	{
+		return g_Buffer;
+	}
+
+	VkDeviceSize GetMaxBindingRange()
+	{
+		return g_MaxBindingRange;
+	}
+
+	void ResetFrame(uint32_t frameInFlightIndex)
+	{
+		auto frameUsage = std::min<uint64_t>(g_FrameHeads[frameInFlightIndex].exchange(0, std::memory_order_relaxed), s_FrameSize);
+		g_PeakFrameUsage = std::max(g_PeakFrameUsage, frameUsage);
+	}
+
+	void Dispose()
+	{
+		if (g_Buffer != VK_NULL_HANDLE)
+		{
+			PXL8_CORE_INFO("Uniform ring peak usage: " + std::to_string(g_PeakFrameUsage) + " of " + std::to_string(s_FrameSize) + " bytes per frame.");
+			vmaDestroyBuffer(g_Allocator, g_Buffer, g_Allocation);
+		}
+
+		g_Buffer = VK_NULL_HANDLE;
+		g_Allocation = VK_NULL_HANDLE;
+		g_pMapped = nullptr;
+		g_DeviceAddress = 0;
+		g_PeakFrameUsage = 0;
+		for (auto& head : g_FrameHeads)
+			head = 0;
+
+		PXL8_CORE_TRACE("Uniform ring disposed successfully.");
+	}
+}
@@ -0,0 +1,576 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include "upload_engine.h"
+#include "queue_manager.h"
+#include "command_buffer_manager.h"
+#include "pixelate_settings.h"
+#include "log.h"
+#include "cpu_profiler.h"
+
+namespace Pixelate::UploadEngine
+{
+	static constexpr uint32_t s_BatchCount = 8; // command buffers submitted or recording at once
+	static constexpr VkDeviceSize s_RingSize = PixelateSettings::UPLOAD_STAGING_RING_SIZE;
+	static constexpr VkDeviceSize s_MaxBufferChunk = s_RingSize / 4; // large buffers are copied in chunks, so they never wait for the whole ring
+	static constexpr VkDeviceSize s_StagingAlignment = 16; // covers the texel size of every uncompressed format up to 128 bits and all block sizes
+
+	struct UploadBatch
+	{
+		VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+		TimelinePoint Complete{};
+		uint64_t RingEnd = 0; // ring position after the batch's last copy, everything before it is free once Complete is reached
+		bool IsRecording = false;
+	};
+
+	std::mutex g_Mutex;
+	PixelateDevice g_Device{};
+	VmaAllocator g_Allocator = VK_NULL_HANDLE;
+	VkBuffer g_RingBuffer = VK_NULL_HANDLE;
+	VmaAllocation g_RingAllocation = VK_NULL_HANDLE;
+	uint8_t* g_pRing = nullptr;
+	VkDeviceSize g_ImageStagingAlignment = s_StagingAlignment;
+	uint64_t g_RingHead = 0; // bytes handed out so far, positions in the ring are modulo its size
+	uint64_t g_RingTail = 0; // start of the oldest staging memory the GPU may still read
+	VkCommandPool g_CommandPool = VK_NULL_HANDLE;
+	UploadBatch g_Batches[s_BatchCount]{};
+	uint32_t g_FirstInFlight = 0; // oldest submitted batch, the recording one follows the ones in flight
+	uint32_t g_InFlightCount = 0;
+	TimelinePoint g_LastSubmitted{ TimelineQueue::Transfer, 0 };
+	std::vector<VkBufferMemoryBarrier2> g_ReleaseBufferBarriers{}; // recorded at the end of the recording batch
+	std::vector<VkImageMemoryBarrier2> g_ReleaseImageBarriers{};
+	std::vector<VkBufferMemoryBarrier2> g_AcquireBufferBarriers{}; // recorded on the graphics queue by the next Flush
+	std::vector<VkImageMemoryBarrier2> g_AcquireImageBarriers{};
+	UploadStatistics g_Statistics{};
+	uint64_t g_LoggedUploadCount = 0;
+	uint32_t g_FlushCount = 0;
+
+	static uint64_t AlignUp(uint64_t value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	void Initialize(PixelateDevice device, VmaAllocator allocator)
+	{
+		g_Device = device;
+		g_Allocator = allocator;
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(device.VkPhysicalDevice, &properties);
+		g_ImageStagingAlignment = std::max(s_StagingAlignment, properties.limits.optimalBufferCopyOffsetAlignment);
+
+		VkBufferCreateInfo bufferCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.size = s_RingSize,
+			.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		};
+
+		// Written front to back with memcpy only, so write-combined memory is fine
+		VmaAllocationCreateInfo allocationCreateInfo
+		{
+			.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+			.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+		};
+
+		VmaAllocationInfo allocationInfo{};
+		if (vmaCreateBuffer(allocator, &bufferCreateInfo, &allocationCreateInfo, &g_RingBuffer, &g_RingAllocation, &allocationInfo) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create the upload staging ring!");
+			return;
+		}
+
+		g_pRing = static_cast<uint8_t*>(allocationInfo.pMappedData);
+
+		VkCommandPoolCreateInfo commandPoolCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+			.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			.queueFamilyIndex = device.QueueFamilyIndices.TransferQueueFamily.value(),
+		};
+
+		if (vkCreateCommandPool(device.VkDevice, &commandPoolCreateInfo, nullptr, &g_CommandPool) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create the upload command pool!");
+			return;
+		}
+
+		VkCommandBuffer commandBuffers[s_BatchCount]{};
+		VkCommandBufferAllocateInfo allocateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.commandPool = g_CommandPool,
+			.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+			.commandBufferCount = s_BatchCount,
+		};
+		vkAllocateCommandBuffers(device.VkDevice, &allocateInfo, commandBuffers);
+
+		for (uint32_t i = 0; i < s_BatchCount; i++)
+			g_Batches[i] = UploadBatch{ .CommandBuffer = commandBuffers[i] };
+
+		PXL8_CORE_TRACE("Upload engine created with a " + std::to_string(s_RingSize) + " byte staging ring.");
+	}
+
+	// Frees the staging memory of completed batches, optionally waiting for the oldest one first
+	static void ReclaimBatches(bool waitForOldest)
+	{
+		while (g_InFlightCount > 0)
+		{
+			auto& batch = g_Batches[g_FirstInFlight];
+
+			if (waitForOldest)
+			{
+				PXL8_PROFILE_SCOPE("UploadEngine::Stall");
+
+				auto stallStart = std::chrono::steady_clock::now();
+				TimelineManager::Wait(batch.Complete);
+
+				g_Statistics.StallCount++;
+				g_Statistics.StallTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stallStart).count();
+				waitForOldest = false;
+			}
+			else if (!TimelineManager::IsComplete(batch.Complete))
+				break;
+
+			g_RingTail = batch.RingEnd;
+			g_FirstInFlight = (g_FirstInFlight + 1) % s_BatchCount;
+			g_InFlightCount--;
+		}
+	}
+
+	static UploadBatch& GetRecordingBatch()
+	{
+		if (g_InFlightCount == s_BatchCount)
+			ReclaimBatches(true);
+
+		auto& batch = g_Batches[(g_FirstInFlight + g_InFlightCount) % s_BatchCount];
+		if (batch.IsRecording)
+			return batch;
+
+		VkCommandBufferBeginInfo beginInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		};
+		vkBeginCommandBuffer(batch.CommandBuffer, &beginInfo);
+
+		// Batches are submitted in the order they are begun, so the reserved values reach the queue in order
+		batch.Complete = TimelineManager::Reserve(TimelineQueue::Transfer);
+		batch.IsRecording = true;
+
+		return batch;
+	}
+
+	static void RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<VkBufferMemoryBarrier2>& bufferBarriers, const std::vector<VkImageMemoryBarrier2>& imageBarriers)
+	{
+		if (bufferBarriers.empty() && imageBarriers.empty())
+			return;
+
+		VkDependencyInfo dependencyInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size()),
+			.pBufferMemoryBarriers = bufferBarriers.data(),
+			.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
+			.pImageMemoryBarriers = imageBarriers.data(),
+		};
+
+		vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+	}
+
+	static void SubmitBatch()
+	{
+		if (g_InFlightCount == s_BatchCount)
+			return;
+
+		auto& batch = g_Batches[(g_FirstInFlight + g_InFlightCount) % s_BatchCount];
+		if (!batch.IsRecording)
+			return;
+
+		// Barriers cover every earlier submission of the queue, so copies split across batches are released together
+		RecordBarriers(batch.CommandBuffer, g_ReleaseBufferBarriers, g_ReleaseImageBarriers);
+		g_ReleaseBufferBarriers.clear();
+		g_ReleaseImageBarriers.clear();
+
+		vkEndCommandBuffer(batch.CommandBuffer);
+
+		VkCommandBufferSubmitInfo commandBufferInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+			.commandBuffer = batch.CommandBuffer,
+			.deviceMask = 0b1,
+		};
+
+		auto signalInfo = TimelineManager::GetSubmitInfo(batch.Complete, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+		VkSubmitInfo2 submitInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &commandBufferInfo,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &signalInfo,
+		};
+
+		QueueManager::TransferQueueSubmit(g_Device, TransferQueueSubmitDescriptor(), &submitInfo, 1, VK_NULL_HANDLE);
+
+		batch.RingEnd = g_RingHead;
+		batch.IsRecording = false;
+		g_InFlightCount++;
+		g_LastSubmitted = batch.Complete;
+		g_Statistics.SubmitCount++;
+	}
+
+	static bool TryAllocateStaging(VkDeviceSize size, VkDeviceSize alignment, uint64_t& position)
+	{
+		// Allocations never wrap around, the rest of the ring is skipped instead
+		auto start = AlignUp(g_RingHead, alignment);
+		if (start % s_RingSize + size > s_RingSize)
+			start = AlignUp(start, s_RingSize);
+
+		if (start + size - g_RingTail > s_RingSize)
+			return false;
+
+		g_RingHead = start + size;
+		position = start;
+
+		return true;
+	}
+
+	// May submit the recording batch and wait for earlier ones when the ring is full, so the copy has to be recorded afterwards
+	static VkDeviceSize AllocateStaging(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		uint64_t position = 0;
+		while (!TryAllocateStaging(size, alignment, position))
+		{
+			ReclaimBatches(false);
+			if (TryAllocateStaging(size, alignment, position))
+				break;
+
+			// Only the recording batch holds staging memory, it has to reach the queue before it can be waited for
+			if (g_InFlightCount == 0)
+				SubmitBatch();
+
+			if (g_InFlightCount > 0)
+				ReclaimBatches(true);
+			else
+				g_RingTail = g_RingHead = AlignUp(g_RingHead, s_RingSize); // the ring is idle, start over at its beginning
+		}
+
+		return position % s_RingSize;
+	}
+
+	static void WriteStaging(VkDeviceSize offset, const void* pData, VkDeviceSize size)
+	{
+		std::memcpy(g_pRing + offset, pData, size);
+		vmaFlushAllocation(g_Allocator, g_RingAllocation, offset, size); // no-op on coherent memory
+	}
+
+	// With a transfer-only family ownership moves to the graphics family, otherwise the copies are only made visible to later work
+	template <typename T>
+	static void AddBarriers(T barrier, std::vector<T>& releaseBarriers, std::vector<T>& acquireBarriers)
+	{
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		if (!g_Device.QueueFamilyIndices.HasDedicatedTransfer())
+		{
+			releaseBarriers.push_back(barrier);
+			return;
+		}
+
+		barrier.srcQueueFamilyIndex = g_Device.QueueFamilyIndices.TransferQueueFamily.value();
+		barrier.dstQueueFamilyIndex = g_Device.QueueFamilyIndices.GraphicsQueueFamily.value();
+
+		auto acquire = barrier;
+		acquire.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+		acquire.srcAccessMask = VK_ACCESS_2_NONE;
+		acquireBarriers.push_back(acquire);
+
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+		barrier.dstAccessMask = VK_ACCESS_2_NONE;
+		releaseBarriers.push_back(barrier);
+	}
+
+	TimelinePoint UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* pData, VkDeviceSize size)
+	{
+		PXL8_PROFILE_SCOPE("UploadEngine::UploadBuffer");
+
+		std::lock_guard<std::mutex> lock(g_Mutex);
+
+		if (size == 0)
+			return g_LastSubmitted;
+
+		auto pBytes = static_cast<const uint8_t*>(pData);
+		for (VkDeviceSize copied = 0; copied < size;)
+		{
+			auto chunkSize = std::min(size - copied, s_MaxBufferChunk);
+			auto stagingOffset = AllocateStaging(chunkSize, s_StagingAlignment);
+			WriteStaging(stagingOffset, pBytes + copied, chunkSize);
+
+			VkBufferCopy region
+			{
+				.srcOffset = stagingOffset,
+				.dstOffset = offset + copied,
+				.size = chunkSize,
+			};
+			vkCmdCopyBuffer(GetRecordingBatch().CommandBuffer, g_RingBuffer, buffer, 1, &region);
+
+			copied += chunkSize;
+		}
+
+		AddBarriers(
+			VkBufferMemoryBarrier2
+			{
+				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+				.buffer = buffer,
+				.offset = offset,
+				.size = size,
+			},
+			g_ReleaseBufferBarriers,
+			g_AcquireBufferBarriers);
+
+		g_Statistics.UploadCount++;
+		g_Statistics.UploadedBytes += size;
+
+		return GetRecordingBatch().Complete;
+	}
+
+	TimelinePoint UploadImage(const ImageUploadDescriptor& descriptor, const void* pData, VkDeviceSize size)
+	{
+		PXL8_PROFILE_SCOPE("UploadEngine::UploadImage");
+
+		std::lock_guard<std::mutex> lock(g_Mutex);
+
+		if (size + g_ImageStagingAlignment > s_RingSize)
+		{
+			PXL8_CORE_ERROR("Image upload of " + std::to_string(size) + " bytes doesn't fit the " + std::to_string(s_RingSize) + " byte staging ring!");
+			return g_LastSubmitted;
+		}
+
+		auto stagingOffset = AllocateStaging(size, g_ImageStagingAlignment);
+		WriteStaging(stagingOffset, pData, size);
+
+		auto commandBuffer = GetRecordingBatch().CommandBuffer;
+		VkImageSubresourceRange subresourceRange{ descriptor.AspectMask, descriptor.MipLevel, 1, descriptor.ArrayLayer, 1 };
+
+		VkImageMemoryBarrier2 toTransferDestination
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+			.srcStageMask = VK_PIPELINE_STAGE_2_NONE,
+			.srcAccessMask = VK_ACCESS_2_NONE,
+			.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+			.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+			.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = descriptor.Image,
+			.subresourceRange = subresourceRange,
+		};
+
+		VkDependencyInfo dependencyInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+			.imageMemoryBarrierCount = 1,
+			.pImageMemoryBarriers = &toTransferDestination,
+		};
+		vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+		VkBufferImageCopy region
+		{
+			.bufferOffset = stagingOffset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = { descriptor.AspectMask, descriptor.MipLevel, descriptor.ArrayLayer, 1 },
+			.imageOffset = { 0, 0, 0 },
+			.imageExtent = descriptor.Extent,
+		};
+		vkCmdCopyBufferToImage(commandBuffer, g_RingBuffer, descriptor.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// The release and the acquire both carry the transition to the final layout, it only happens once
+		AddBarriers(
+			VkImageMemoryBarrier2
+			{
+				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+				.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				.newLayout = descriptor.FinalLayout,
+				.image = descriptor.Image,
+				.subresourceRange = subresourceRange,
+			},
+			g_ReleaseImageBarriers,
+			g_AcquireImageBarriers);
+
+		g_Statistics.UploadCount++;
+		g_Statistics.UploadedBytes += size;
+
+		return GetRecordingBatch().Complete;
+	}
+
+	static void LogStatistics()
+	{
+		const auto& statistics = g_Statistics;
+		PXL8_CORE_INFO("Uploads: " + std::to_string(statistics.UploadCount) + " uploads, " + std::to_string(statistics.UploadedBytes) + " bytes in "
+			+ std::to_string(statistics.SubmitCount) + " submits, " + std::to_string(statistics.StallCount) + " stalls for staging memory ("
+			+ std::to_string(statistics.StallTime) + " ms).");
+	}
+
+	TimelinePoint Flush(uint32_t frameInFlightIndex)
+	{
+		PXL8_PROFILE_SCOPE("UploadEngine::Flush");
+
+		std::lock_guard<std::mutex> lock(g_Mutex);
+
+		SubmitBatch();
+		ReclaimBatches(false);
+
+		if (!g_AcquireBufferBarriers.empty() || !g_AcquireImageBarriers.empty())
+		{
+			auto commandBuffer = CommandBufferManager::GetFrameCommandBuffer(g_Device, frameInFlightIndex);
+
+			VkCommandBufferBeginInfo beginInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+				.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			};
+			vkBeginCommandBuffer(commandBuffer, &beginInfo);
+			RecordBarriers(commandBuffer, g_AcquireBufferBarriers, g_AcquireImageBarriers);
+			vkEndCommandBuffer(commandBuffer);
+
+			g_AcquireBufferBarriers.clear();
+			g_AcquireImageBarriers.clear();
+
+			VkCommandBufferSubmitInfo commandBufferInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+				.commandBuffer = commandBuffer,
+				.deviceMask = 0b1,
+			};
+
+			// The latest transfer value covers every batch released so far
+			auto waitInfo = TimelineManager::GetSubmitInfo(g_LastSubmitted, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+			VkSubmitInfo2 submitInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+				.waitSemaphoreInfoCount = 1,
+				.pWaitSemaphoreInfos = &waitInfo,
+				.commandBufferInfoCount = 1,
+				.pCommandBufferInfos = &commandBufferInfo,
+			};
+
+			QueueManager::GraphicsQueueSubmit(g_Device, GraphicsQueueSubmitDescriptor(), &submitInfo, 1, VK_NULL_HANDLE);
+		}
+
+		if (++g_FlushCount >= PixelateSettings::FRAME_STATISTICS_LOG_INTERVAL)
+		{
+			if (g_Statistics.UploadCount > g_LoggedUploadCount)
+				LogStatistics();
+
+			g_LoggedUploadCount = g_Statistics.UploadCount;
+			g_FlushCount = 0;
+		}
+
+		return g_LastSubmitted;
+	}
+
+	const UploadStatistics& GetStatistics()
+	{
+		return g_Statistics;
+	}
+
+	void LogBenchmark(VkDeviceSize byteCount)
+	{
+		constexpr VkDeviceSize uploadSize = 4 * 1024 * 1024;
+
+		std::vector<uint8_t> data(uploadSize);
+		for (size_t i = 0; i < data.size(); i++)
+			data[i] = static_cast<uint8_t>(i * 31 + 7);
+
+		VkBufferCreateInfo bufferCreateInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+			.size = uploadSize,
+			.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		};
+
+		VmaAllocationCreateInfo allocationCreateInfo
+		{
+			.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+		};
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VmaAllocation allocation = VK_NULL_HANDLE;
+		if (vmaCreateBuffer(g_Allocator, &bufferCreateInfo, &allocationCreateInfo, &buffer, &allocation, nullptr) != VK_SUCCESS)
+		{
+			PXL8_CORE_ERROR("Failed to create the upload benchmark buffer!");
+			return;
+		}
+
+		auto statisticsBefore = g_Statistics;
+		auto start = std::chrono::steady_clock::now();
+
+		TimelinePoint complete{};
+		for (VkDeviceSize uploaded = 0; uploaded < byteCount; uploaded += uploadSize)
+			complete = UploadBuffer(buffer, 0, data.data(), uploadSize);
+
+		{
+			std::lock_guard<std::mutex> lock(g_Mutex);
+			SubmitBatch();
+		}
+
+		TimelineManager::Wait(complete);
+		auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		// The scratch buffer is never used on the graphics queue, so it is never acquired
+		{
+			std::lock_guard<std::mutex> lock(g_Mutex);
+			ReclaimBatches(false);
+			std::erase_if(g_AcquireBufferBarriers, [buffer](const VkBufferMemoryBarrier2& barrier) { return barrier.buffer == buffer; });
+		}
+
+		vmaDestroyBuffer(g_Allocator, buffer, allocation);
+
+		auto uploadedBytes = g_Statistics.UploadedBytes - statisticsBefore.UploadedBytes;
+		PXL8_CORE_INFO("Upload benchmark: " + std::to_string(uploadedBytes) + " bytes in " + std::to_string(time * 1000.0) + " ms, "
+			+ std::to_string(uploadedBytes / time / (1024.0 * 1024.0 * 1024.0)) + " GiB/s, "
+			+ std::to_string(g_Statistics.SubmitCount - statisticsBefore.SubmitCount) + " submits, "
+			+ std::to_string(g_Statistics.StallCount - statisticsBefore.StallCount) + " stalls for staging memory.");
+	}
+
+	void Dispose()
+	{
+		// Copies that were never flushed are dropped with the pool, the device is idle by now.
+		// Their batch reserved a transfer value that never reached the queue, signal it so waits on those uploads still return.
+		for (auto& batch : g_Batches)
+		{
+			if (batch.IsRecording)
+				TimelineManager::Signal(batch.Complete);
+
+			batch = UploadBatch{};
+		}
+
+		vkDestroyCommandPool(g_Device.VkDevice, g_CommandPool, nullptr);
+		vmaDestroyBuffer(g_Allocator, g_RingBuffer, g_RingAllocation);
+
+		g_CommandPool = VK_NULL_HANDLE;
+		g_RingBuffer = VK_NULL_HANDLE;
+		g_RingAllocation = VK_NULL_HANDLE;
+		g_pRing = nullptr;
+		g_RingHead = g_RingTail = 0;
+		g_FirstInFlight = g_InFlightCount = 0;
+		g_ReleaseBufferBarriers.clear();
+		g_ReleaseImageBarriers.clear();
+		g_AcquireBufferBarriers.clear();
+		g_AcquireImageBarriers.clear();
+
+		PXL8_CORE_TRACE("Upload engine disposed successfully.");
+	}
+}
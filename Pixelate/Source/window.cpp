@@ -27,7 +27,7 @@ namespace Pixelate
 	SDL_Window* InitializeSDLWindow(const char* name, int x, int y, int width, int height)
 	{
 		InitializeSDL();
-		auto window = SDL_CreateWindow(name, x, y, width, height, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN);
+		auto window = SDL_CreateWindow(name, x, y, width, height, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
 
 		if (window)
 			PXL8_APP_TRACE("SDL window created successfully.");
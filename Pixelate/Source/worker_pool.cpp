@@ -0,0 +1,65 @@
+#include "worker_pool.h"
+#include "log.h"
+#include "cpu_profiler.h"
+
+namespace Pixelate
+{
+	WorkerPool::WorkerPool(const char* name, uint32_t threadCount) : m_Name(name)
+	{
+		threadCount = std::max(threadCount, 1u);
+
+		m_Threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Threads.emplace_back(&WorkerPool::WorkerLoop, this);
+
+		PXL8_CORE_TRACE(std::string("Worker pool \"") + m_Name + "\" started with " + std::to_string(threadCount) + " threads.");
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		Dispose();
+	}
+
+	void WorkerPool::Submit(std::function<void()> job)
+	{
+		m_Jobs.push(std::move(job));
+	}
+
+	void WorkerPool::Dispose()
+	{
+		if (m_Threads.empty())
+			return;
+
+		// An empty job tells a worker to exit, queued after all pending work
+		for (size_t i = 0; i < m_Threads.size(); i++)
+			m_Jobs.push(std::function<void()>());
+
+		for (auto& thread : m_Threads)
+			thread.join();
+
+		m_Threads.clear();
+
+		PXL8_CORE_TRACE(std::string("Worker pool \"") + m_Name + "\" disposed successfully.");
+	}
+
+	uint32_t WorkerPool::GetDefaultThreadCount()
+	{
+		auto coreCount = std::thread::hardware_concurrency();
+		return coreCount > 1 ? coreCount - 1 : 1;
+	}
+
+	void WorkerPool::WorkerLoop()
+	{
+		CpuProfiler::SetThreadName(m_Name);
+
+		while (true)
+		{
+			auto job = m_Jobs.pop();
+
+			if (!job)
+				return;
+
+			job();
+		}
+	}
+}
@@ -11,6 +11,7 @@ namespace Pixelize
 	constexpr int WINDOW_OFFSET_Y = SDL_WINDOWPOS_CENTERED;
 	constexpr int WINDOW_WIDTH = 1080;
 	constexpr int WINDOW_HEIGHT = 720;
+	constexpr uint32_t TRACE_FRAME_COUNT = 256;
 
 	bool HandleInput()
 	{
@@ -55,10 +56,10 @@ namespace Pixelize
 	}
 }
 
-void TrianglePassCommandBuffer(VkCommandBuffer commandBuffer, VkPipeline pipelineHandle)
+void TrianglePassCommandBuffer(PixelatePassContext& context)
 {
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineHandle);
-	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+	vkCmdBindPipeline(context.CommandBuffer, context.BindPoint, context.Pipeline);
+	vkCmdDraw(context.CommandBuffer, 3, 1, 0, 0);
 }
 
 static PixelatePass GetTrianglePass()
@@ -99,9 +100,66 @@ static PixelatePass GetTrianglePass()
 	return trianglePass;
 }
 
+// Usage: Pixelize [--frames <count>] [--headless] [--trace <file>] [--benchmark-hasher] [--benchmark-uploads <MiB>] [--resize-every <count>] [--serialize-frames]
+// With --frames the application exits after rendering <count> frames and prints frame pacing statistics.
+// With --headless no window is created and frames are rendered offscreen, e.g. on lavapipe in CI.
+// With --trace the CPU profiler is enabled and the last frames are written to <file> as Chrome trace JSON on exit.
+// With --benchmark-hasher the hasher throughput is measured and logged before rendering.
+// With --benchmark-uploads <MiB> that much data is streamed through the upload engine and its throughput is logged before rendering.
+// With --resize-every <count> the surface alternates between two sizes every <count> frames and the swapchain recreation latency is printed,
+// headless this resizes the simulated surface.
+// With --serialize-frames every frame waits for the device to go idle, the baseline to compare pipelined frame pacing against.
+static const char* GetArgument(int argc, char** argv, const char* flag)
+{
+	for (int i = 1; i + 1 < argc; i++)
+		if (strcmp(argv[i], flag) == 0)
+			return argv[i + 1];
+
+	return nullptr;
+}
+
+static uint64_t ParseFrameLimit(int argc, char** argv)
+{
+	auto frames = GetArgument(argc, argv, "--frames");
+	return frames != nullptr ? std::strtoull(frames, nullptr, 10) : 0;
+}
+
+static bool HasFlag(int argc, char** argv, const char* flag)
+{
+	for (int i = 1; i < argc; i++)
+		if (strcmp(argv[i], flag) == 0)
+			return true;
+
+	return false;
+}
+
 int main(int argc, char** argv)
 {	
-	auto renderer = Pixelate::Renderer("Pixelize", Pixelize::WINDOW_OFFSET_X, Pixelize::WINDOW_OFFSET_Y, Pixelize::WINDOW_WIDTH, Pixelize::WINDOW_HEIGHT);
+	auto frameLimit = ParseFrameLimit(argc, argv);
+	auto headless = HasFlag(argc, argv, "--headless");
+	auto traceFilepath = GetArgument(argc, argv, "--trace");
+
+	CpuProfiler::SetEnabled(traceFilepath != nullptr);
+
+	auto renderer = Pixelate::Renderer(
+		"Pixelize",
+		Pixelize::WINDOW_OFFSET_X,
+		Pixelize::WINDOW_OFFSET_Y,
+		Pixelize::WINDOW_WIDTH,
+		Pixelize::WINDOW_HEIGHT,
+		headless ? Pixelate::PresentationBackend::Headless : Pixelate::PresentationBackend::Window);
+
+	renderer.SetSerializeFrames(HasFlag(argc, argv, "--serialize-frames"));
+
+	if (headless && frameLimit == 0)
+		PXL8_APP_WARN("Running headless without --frames, there is no window to close.");
+
+	if (HasFlag(argc, argv, "--benchmark-hasher"))
+		Pixelate::Hashers::LogBenchmark();
+
+	auto uploadBenchmarkSize = GetArgument(argc, argv, "--benchmark-uploads");
+	if (uploadBenchmarkSize != nullptr)
+		Pixelate::UploadEngine::LogBenchmark(std::strtoull(uploadBenchmarkSize, nullptr, 10) * 1024 * 1024);
 
 	Pixelate::RenderGraphDescriptor renderGraphDescriptor
 	{
@@ -113,7 +171,51 @@ int main(int argc, char** argv)
 	
 	auto renderGraph = renderer.BuildRenderGraph(renderGraphDescriptor);
 
-	renderer.Render(renderGraph, Pixelize::HandleInput);
+	auto resizeInterval = GetArgument(argc, argv, "--resize-every");
+	auto resizeFrameInterval = resizeInterval != nullptr ? std::strtoull(resizeInterval, nullptr, 10) : 0;
+
+	uint64_t frameCount = 0;
+	renderer.Render(renderGraph, [frameLimit, headless, resizeFrameInterval, &frameCount, &renderer]()
+		{
+			// Counted whether or not there is a frame limit, --resize-every works on its own
+			frameCount++;
+
+			auto quit = !headless && Pixelize::HandleInput();
+
+			if (resizeFrameInterval > 0 && frameCount % resizeFrameInterval == 0)
+			{
+				auto shrink = (frameCount / resizeFrameInterval) % 2 == 1;
+				renderer.ResizeSurface(shrink ? Pixelize::WINDOW_WIDTH / 2 : Pixelize::WINDOW_WIDTH, shrink ? Pixelize::WINDOW_HEIGHT / 2 : Pixelize::WINDOW_HEIGHT);
+			}
+
+			return quit || (frameLimit > 0 && frameCount >= frameLimit); // the frame that returns true is still rendered
+		});
+
+	const auto& statistics = renderer.GetFramePacingStatistics();
+	PXL8_APP_INFO(
+		"Rendered " + std::to_string(statistics.FrameCount) + " frames:"
+		+ " average frame time " + std::to_string(statistics.AverageFrameTime()) + " ms,"
+		+ " average fence wait " + std::to_string(statistics.AverageFenceWait()) + " ms,"
+		+ " CPU/GPU overlap " + std::to_string(statistics.CpuGpuOverlap() * 100.0) + "%");
+
+	const auto& recreationStatistics = renderer.GetSwapchainRecreationStatistics();
+	if (recreationStatistics.RecreationCount > 0)
+		PXL8_APP_INFO(
+			"Recreated the swapchain " + std::to_string(recreationStatistics.RecreationCount) + " times:"
+			+ " latency min/avg/max " + std::to_string(recreationStatistics.TimeMin)
+			+ "/" + std::to_string(recreationStatistics.AverageTime())
+			+ "/" + std::to_string(recreationStatistics.TimeMax) + " ms");
+
+	const auto& resourceStatistics = renderGraph.GetResourceStatistics();
+	PXL8_APP_INFO(
+		"Render graph resources: " + std::to_string(resourceStatistics.AllocatedBytes) + " bytes allocated,"
+		+ " " + std::to_string(resourceStatistics.BytesSaved()) + " bytes saved by aliasing and lazy allocation");
+
+	for (const auto& timing : renderGraph.GetGpuPassTimings())
+		PXL8_APP_INFO(std::string("GPU time of ") + timing.PassName + ": last " + std::to_string(timing.LastTime) + " ms");
+
+	if (traceFilepath != nullptr)
+		CpuProfiler::ExportChromeTrace(traceFilepath, Pixelize::TRACE_FRAME_COUNT);
 
 	return 0;
 }
@@ -5,13 +5,17 @@ pixelateSourcePath = "Pixelate/Source"
 
 workspace "Pixelate"
 	configurations { "Debug", "Debug_Verbose", "Release" }
-	platforms { "Win64" }
+	platforms { "Win64", "Linux64" }
 	startproject "Pixelize"
 
 filter { "platforms:Win64" }
 	system "Windows"
 	architecture "x86_64"
 
+filter { "platforms:Linux64" }
+	system "linux"
+	architecture "x86_64"
+
 project "Pixelate"
 	kind "StaticLib"
 	language "C++"
@@ -57,6 +61,9 @@ project "Pixelate"
 	filter "platforms:Win64"
 	defines { "WIN64" }
 
+	filter "platforms:Linux64"
+	defines { "LINUX64" }
+
 	filter "action:vs*"
 		buildoptions { "/MP" }
 